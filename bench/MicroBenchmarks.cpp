@@ -0,0 +1,411 @@
+#include "MicroBenchmarks.h"
+#include "CorePCH.h"
+#include "EditorIDIndex.h"
+#include "ExtraPartResolver.h"
+#include "FormIDManager.h"
+#include "FormIDUtils.h"
+#include "HeadPartClassifier.h"
+#include "HeadPartRules.h"
+#include "SyntheticLoadOrder.h"
+
+#include <random>
+#include <thread>
+
+namespace
+{
+	// Results are folded in here so the timed work can't be optimized away
+	volatile std::uint64_t sink = 0;
+
+	// Average milliseconds per call of a_function
+	template <class F>
+	double TimeMilliseconds(std::uint32_t a_iterations, F&& a_function)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		for (std::uint32_t i = 0; i < a_iterations; ++i) {
+			a_function();
+		}
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / a_iterations;
+	}
+
+	void PrintTime(std::string_view a_label, double a_milliseconds)
+	{
+		fmt::print("  {:<24}{:>10.3f} ms\n", a_label, a_milliseconds);
+	}
+
+	// EditorID lookups through the index against the rescan of every head part it replaced
+	void RunEditorIDLookup(std::uint32_t a_iterations)
+	{
+		SyntheticLoadOrderParams params;
+		params.headPartCount = 100000;
+		const auto source = MakeSyntheticLoadOrder(params);
+		const auto headParts = source->GetHeadParts();
+
+		// Spread over the whole form array, as the parts flipped extra parts reuse are
+		std::vector<Hash::HashedKey> keys;
+		for (std::size_t i = 0; i < 1000; ++i) {
+			keys.emplace_back(headParts[i * headParts.size() / 1000].editorID);
+		}
+
+		EditorIDIndex index;
+		const auto buildTime = TimeMilliseconds(a_iterations, [&] { index.Build(*source); });
+		const auto indexTime = TimeMilliseconds(a_iterations, [&] {
+			for (const auto& key : keys) {
+				sink = sink + index.Find(key);
+			}
+		});
+		const auto scanTime = TimeMilliseconds(a_iterations, [&] {
+			for (const auto& key : keys) {
+				const auto it = std::ranges::find(headParts, key.str, &HeadPartRecord::editorID);
+				sink = sink + (it != headParts.end() ? it->formID : 0);
+			}
+		});
+
+		fmt::print("EditorID lookup ({} lookups in {} head parts)\n", keys.size(), headParts.size());
+		PrintTime("Index build", buildTime);
+		PrintTime("Index lookups", indexTime);
+		PrintTime("Form array rescans", scanTime);
+		fmt::print("\n");
+	}
+
+	// The stable FNV-1a hash against the std::hash older builds derived FormIDs from, over flipped EditorIDs
+	void RunHashThroughput(std::uint32_t a_iterations)
+	{
+		constexpr std::array types = { HeadPartType::kHair, HeadPartType::kFacialHair, HeadPartType::kScar, HeadPartType::kEyebrows };
+		StringArena arena;
+		std::vector<std::string_view> editorIDs;
+		std::size_t byteCount = 0;
+		for (std::uint32_t i = 0; i < 100000; ++i) {
+			editorIDs.push_back(arena.Intern(fmt::format("Synthetic{}{:06}_Unisexy", GetHeadPartTypeName(types[i % types.size()]), i)));
+			byteCount += editorIDs.back().size();
+		}
+
+		const auto fnvTime = TimeMilliseconds(a_iterations, [&] {
+			for (const auto editorID : editorIDs) {
+				sink = sink + Hash::FNV1a(editorID);
+			}
+		});
+		const auto stdTime = TimeMilliseconds(a_iterations, [&] {
+			for (const auto editorID : editorIDs) {
+				sink = sink + std::hash<std::string_view>{}(editorID);
+			}
+		});
+		const auto stableTime = TimeMilliseconds(a_iterations, [&] {
+			for (const auto editorID : editorIDs) {
+				sink = sink + FormIDUtils::GenerateStableBaseFormID(editorID, false);
+			}
+		});
+		const auto legacyTime = TimeMilliseconds(a_iterations, [&] {
+			for (const auto editorID : editorIDs) {
+				sink = sink + FormIDUtils::GenerateLegacyBaseFormID(editorID, false);
+			}
+		});
+
+		const auto printThroughput = [&](std::string_view a_label, double a_milliseconds) {
+			fmt::print("  {:<24}{:>10.3f} ms ({:.0f} MiB/s)\n", a_label, a_milliseconds,
+				static_cast<double>(byteCount) / (1024.0 * 1024.0) / (a_milliseconds / 1000.0));
+		};
+		fmt::print("Hash throughput ({} EditorIDs, {:.1f} KiB)\n", editorIDs.size(), static_cast<double>(byteCount) / 1024.0);
+		printThroughput("FNV-1a", fnvTime);
+		printThroughput("std::hash", stdTime);
+		printThroughput("Stable FormIDs", stableTime);
+		printThroughput("Legacy FormIDs", legacyTime);
+		fmt::print("\n");
+	}
+
+	// FormID assignment through the occupancy pre-scan, through per-plugin scans on first use,
+	// and through the per-probe form and plugin name lookups it replaced
+	void RunConflictProbe(std::uint32_t a_iterations, double a_conflictDensity)
+	{
+		SyntheticLoadOrderParams params;
+		params.headPartCount = 100000;
+		params.conflictDensity = a_conflictDensity;
+		// Full plugins only, so probe counts follow the conflict density instead of exhausted light plugins
+		params.lightPluginShare = 0.0;
+		const auto source = MakeSyntheticLoadOrder(params);
+
+		// Every gendered part is flipped into the plugin providing it
+		StringArena arena;
+		std::vector<std::pair<Hash::HashedKey, const PluginInfo*>> assignments;
+		std::vector<const PluginInfo*> targetFiles;
+		for (const auto& headPart : source->GetHeadParts()) {
+			if (headPart.HasFlag(HeadPartFlag::kMale) != headPart.HasFlag(HeadPartFlag::kFemale)) {
+				assignments.emplace_back(MakeUnisexyEditorID(headPart.editorID, arena), headPart.file);
+				if (std::ranges::find(targetFiles, headPart.file) == targetFiles.end()) {
+					targetFiles.push_back(headPart.file);
+				}
+			}
+		}
+
+		const auto assignAll = [&](FormIDManager& a_formIDManager) {
+			std::uint32_t conflictFormID = 0;
+			for (const auto& [editorID, targetFile] : assignments) {
+				sink = sink + a_formIDManager.AssignFormID(editorID, targetFile, conflictFormID);
+			}
+		};
+		const auto preScanTime = TimeMilliseconds(a_iterations, [&] {
+			FormIDManager formIDManager(*source, FormIDUtils::HashMode::kStable, false);
+			formIDManager.SeedOccupancy(targetFiles);
+			assignAll(formIDManager);
+		});
+		const auto lazyScanTime = TimeMilliseconds(a_iterations, [&] {
+			FormIDManager formIDManager(*source, FormIDUtils::HashMode::kStable, false);
+			assignAll(formIDManager);
+		});
+
+		// Each probe found the plugin by name and looked the full FormID up in the form map
+		std::size_t probeCount = 0;
+		const auto lookupTime = TimeMilliseconds(a_iterations, [&] {
+			std::unordered_set<FormID> assigned;
+			probeCount = 0;
+			for (const auto& [editorID, targetFile] : assignments) {
+				const auto fileName = targetFile->fileName;
+				auto localID = FormIDUtils::GenerateBaseFormID(editorID, targetFile->isLight, FormIDUtils::HashMode::kStable);
+				for (std::uint32_t attempt = 0; attempt <= FormIDUtils::GetMaxLocalID(targetFile->isLight); ++attempt) {
+					++probeCount;
+					const auto* plugin = *std::ranges::find(targetFiles, fileName, &PluginInfo::fileName);
+					const auto formID = FormIDUtils::MakeFormID(plugin->compileIndex, plugin->isLight, localID);
+					if (!source->HasForm(formID) && assigned.insert(formID).second) {
+						break;
+					}
+					localID = localID > FormIDUtils::FORMID_MIN ? localID - 1 : FormIDUtils::GetMaxLocalID(plugin->isLight);
+				}
+			}
+		});
+
+		fmt::print("Conflict probe ({} assignments in {} plugins, conflict density {}, {} probes)\n",
+			assignments.size(), targetFiles.size(), a_conflictDensity, probeCount);
+		PrintTime("Pre-scanned occupancy", preScanTime);
+		PrintTime("Scan on first use", lazyScanTime);
+		PrintTime("Lookup per probe", lookupTime);
+		fmt::print("\n");
+	}
+
+	// A million classifications through the table against the per-type map lookups and branches it replaced
+	void RunClassifierTable(std::uint32_t a_iterations)
+	{
+		using Classification = HeadPartClassifier::Classification;
+
+		std::array<HeadPartClassifier::TypeToggles, HeadPartClassifier::TYPE_COUNT> toggles{};
+		toggles[std::to_underlying(HeadPartType::kHair)] = { true, true };
+		toggles[std::to_underlying(HeadPartType::kEyebrows)] = { false, true };
+		HeadPartClassifier classifier;
+		classifier.Build(toggles);
+		std::map<HeadPartType, HeadPartClassifier::TypeToggles> toggleMap;
+		for (std::size_t type = 0; type < toggles.size(); ++type) {
+			toggleMap.emplace(static_cast<HeadPartType>(type), toggles[type]);
+		}
+
+		std::mt19937 random(1);
+		std::vector<std::pair<HeadPartType, std::uint8_t>> inputs(1000000);
+		for (auto& [type, flags] : inputs) {
+			type = static_cast<HeadPartType>(random() % HeadPartClassifier::TYPE_COUNT);
+			flags = static_cast<std::uint8_t>(random() % 8);
+		}
+
+		const auto tableTime = TimeMilliseconds(a_iterations, [&] {
+			std::uint64_t toFemaleCount = 0;
+			for (const auto& [type, flags] : inputs) {
+				toFemaleCount += classifier.Classify(type, flags) == Classification::kToFemale;
+			}
+			sink = sink + toFemaleCount;
+		});
+		const auto mapTime = TimeMilliseconds(a_iterations, [&] {
+			std::uint64_t toFemaleCount = 0;
+			for (const auto& [type, flags] : inputs) {
+				const bool isMale = (flags & std::to_underlying(HeadPartFlag::kMale)) != 0;
+				const bool isFemale = (flags & std::to_underlying(HeadPartFlag::kFemale)) != 0;
+				const auto isEnabled = [&](bool HeadPartClassifier::TypeToggles::*a_toggle) {
+					const auto it = toggleMap.find(type);
+					return it != toggleMap.end() && it->second.*a_toggle;
+				};
+				auto classification = Classification::kNone;
+				if ((flags & std::to_underlying(HeadPartFlag::kPlayable)) == 0) {
+					classification = Classification::kNonPlayable;
+				} else if (type == HeadPartType::kMisc) {
+					classification = Classification::kMisc;
+				} else if (isMale == isFemale) {
+					classification = isMale ? Classification::kBothGenders : Classification::kGenderless;
+				} else if (isMale) {
+					classification = isEnabled(&HeadPartClassifier::TypeToggles::femaleEnabled) ? Classification::kToFemale : Classification::kFemaleDisabled;
+				} else {
+					classification = isEnabled(&HeadPartClassifier::TypeToggles::maleEnabled) ? Classification::kToMale : Classification::kMaleDisabled;
+				}
+				toFemaleCount += classification == Classification::kToFemale;
+			}
+			sink = sink + toFemaleCount;
+		});
+
+		fmt::print("Classification ({} head parts)\n", inputs.size());
+		PrintTime("Table", tableTime);
+		PrintTime("Map and branches", mapTime);
+		fmt::print("\n");
+	}
+
+	// Head parts whose extra parts are chains a_depth deep, each level a_width male parts that all link to the whole next level
+	std::unique_ptr<MemoryHeadPartSource> MakeExtraPartChains(std::uint32_t a_chainCount, std::uint32_t a_depth, std::uint32_t a_width)
+	{
+		auto source = std::make_unique<MemoryHeadPartSource>();
+		const auto* plugin = source->AddPlugin("Chains.esp", false);
+		std::uint32_t localID = FormIDUtils::FORMID_MIN;
+		const auto addPart = [&](std::string_view a_editorID, std::uint8_t a_flags) {
+			return source->AddHeadPart(plugin, localID++, a_editorID, HeadPartType::kHair, a_flags);
+		};
+
+		constexpr auto male = std::to_underlying(HeadPartFlag::kMale);
+		std::vector<FormID> level;
+		std::vector<FormID> nextLevel;
+		for (std::uint32_t chain = 0; chain < a_chainCount; ++chain) {
+			level = { addPart(fmt::format("ChainHair{:06}", chain), std::to_underlying(HeadPartFlag::kPlayable) | male) };
+			for (std::uint32_t depth = 0; depth < a_depth; ++depth) {
+				nextLevel.clear();
+				for (std::uint32_t i = 0; i < a_width; ++i) {
+					nextLevel.push_back(addPart(fmt::format("ChainPart{:06}_{:02}_{}", chain, depth, i), male));
+				}
+				for (const auto parent : level) {
+					for (const auto child : nextLevel) {
+						source->AddExtraPart(parent, child);
+					}
+				}
+				std::swap(level, nextLevel);
+			}
+		}
+		source->Finalize();
+		return source;
+	}
+
+	// Extra part resolution over growing chain graphs; time per planned part should stay flat
+	void RunExtraPartChains(std::uint32_t a_iterations)
+	{
+		struct Shape
+		{
+			std::uint32_t chainCount;
+			std::uint32_t depth;
+			std::uint32_t width;
+		};
+		constexpr std::array shapes = {
+			Shape{ 1000, 16, 1 },
+			Shape{ 10000, 16, 1 },
+			Shape{ 1000, 64, 1 },
+			Shape{ 1000, 16, 4 },
+			Shape{ 10000, 16, 4 },
+		};
+
+		// Chains deeper than the limit warn once per chain
+		const auto logLevel = spdlog::get_level();
+		spdlog::set_level(spdlog::level::err);
+
+		fmt::print("Extra part chains (resolution stops at depth {})\n", ExtraPartResolver::MAX_DEPTH);
+		for (const auto& shape : shapes) {
+			const auto source = MakeExtraPartChains(shape.chainCount, shape.depth, shape.width);
+			const auto* plugin = source->GetHeadParts().front().file;
+			std::vector<const HeadPartRecord*> heads;
+			for (const auto& headPart : source->GetHeadParts()) {
+				if (headPart.HasFlag(HeadPartFlag::kPlayable)) {
+					heads.push_back(&headPart);
+				}
+			}
+
+			// Only the resolution is timed; the index and the FormID scan are set up first
+			std::size_t plannedCount = 0;
+			double time = 0.0;
+			for (std::uint32_t i = 0; i < a_iterations; ++i) {
+				StringArena arena;
+				EditorIDIndex editorIDIndex;
+				editorIDIndex.Build(*source);
+				FormIDManager formIDManager(*source, FormIDUtils::HashMode::kStable, false);
+				formIDManager.SeedOccupancy(std::span(&plugin, 1));
+				GenerationPlan plan;
+				std::vector<std::tuple<std::string_view, std::uint32_t, std::uint32_t>> conflicts;
+				ExtraPartResolver resolver(formIDManager, editorIDIndex, arena, false, plan, conflicts);
+				std::vector<FormID> extraParts;
+				time += TimeMilliseconds(1, [&] {
+					for (const auto* head : heads) {
+						extraParts.clear();
+						resolver.Resolve(head, true, plugin, extraParts);
+					}
+				}) / a_iterations;
+				plannedCount = plan.headParts.size();
+			}
+			fmt::print("  {:>5} chains, depth {:>2}, width {}: {:>10.3f} ms, {} parts planned, {:.0f} ns per part\n",
+				shape.chainCount, shape.depth, shape.width, time, plannedCount, time * 1e6 / (std::max)(plannedCount, std::size_t{ 1 }));
+		}
+		fmt::print("\n");
+		spdlog::set_level(logLevel);
+	}
+
+	// The planner's per-part classification, sequential, through the parallel algorithm and split over 1..N threads
+	void RunClassifyScaling(std::uint32_t a_iterations)
+	{
+		SyntheticLoadOrderParams params;
+		params.headPartCount = 100000;
+		const auto source = MakeSyntheticLoadOrder(params);
+		const auto headParts = source->GetHeadParts();
+
+		std::array<HeadPartClassifier::TypeToggles, HeadPartClassifier::TYPE_COUNT> toggles{};
+		toggles.fill({ true, true });
+		HeadPartClassifier classifier;
+		classifier.Build(toggles);
+		HeadPartRules rules;
+		rules.Add(HeadPartRules::Kind::kExcludeEditorID, "*Vampire*");
+
+		using Classification = HeadPartClassifier::Classification;
+		const auto classify = [&](const HeadPartRecord& a_headPart) {
+			auto classification = classifier.Classify(a_headPart.type, a_headPart.flags);
+			if (classification == Classification::kToFemale || classification == Classification::kToMale) {
+				if (a_headPart.editorID.empty()) {
+					classification = Classification::kNoEditorID;
+				} else if (!rules.IsEditorIDAllowed(a_headPart.editorID)) {
+					classification = Classification::kExcludedByRule;
+				}
+			}
+			return classification;
+		};
+
+		std::vector<Classification> results(headParts.size());
+		const auto sequentialTime = TimeMilliseconds(a_iterations, [&] {
+			std::transform(std::execution::seq, headParts.begin(), headParts.end(), results.begin(), classify);
+		});
+		const auto parallelTime = TimeMilliseconds(a_iterations, [&] {
+			std::transform(std::execution::par, headParts.begin(), headParts.end(), results.begin(), classify);
+		});
+
+		fmt::print("Classification scaling ({} head parts, {} hardware threads)\n", headParts.size(), std::thread::hardware_concurrency());
+		PrintTime("Sequential", sequentialTime);
+		PrintTime("Parallel algorithm", parallelTime);
+
+		// Powers of two up to the hardware thread count, and the count itself
+		const auto maxThreads = (std::max)(std::thread::hardware_concurrency(), 1u);
+		std::vector<std::uint32_t> threadCounts;
+		for (std::uint32_t threadCount = 1; threadCount < maxThreads; threadCount *= 2) {
+			threadCounts.push_back(threadCount);
+		}
+		threadCounts.push_back(maxThreads);
+		for (const auto threadCount : threadCounts) {
+			const auto time = TimeMilliseconds(a_iterations, [&] {
+				std::vector<std::jthread> threads;
+				threads.reserve(threadCount);
+				for (std::uint32_t i = 0; i < threadCount; ++i) {
+					const auto begin = headParts.size() * i / threadCount;
+					const auto end = headParts.size() * (i + 1) / threadCount;
+					threads.emplace_back([&, begin, end] {
+						std::transform(headParts.begin() + begin, headParts.begin() + end, results.begin() + begin, classify);
+					});
+				}
+			});
+			PrintTime(threadCount == 1 ? "1 thread" : fmt::format("{} threads", threadCount), time);
+		}
+		sink = sink + std::ranges::count(results, Classification::kToFemale);
+		fmt::print("\n");
+	}
+}
+
+void RunMicroBenchmarks(std::uint32_t a_iterations)
+{
+	RunEditorIDLookup(a_iterations);
+	RunClassifierTable(a_iterations);
+	RunClassifyScaling(a_iterations);
+	RunHashThroughput(a_iterations);
+	RunConflictProbe(a_iterations, 0.1);
+	RunConflictProbe(a_iterations, 0.9);
+	RunExtraPartChains(a_iterations);
+}
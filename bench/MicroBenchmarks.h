@@ -0,0 +1,5 @@
+#pragma once
+
+// Time single building blocks of the planner against the code paths they replaced
+// Each benchmark prints its own section, averaged over a_iterations runs
+void RunMicroBenchmarks(std::uint32_t a_iterations);
@@ -0,0 +1,200 @@
+#include "CorePCH.h"
+#include "GenerationPlanner.h"
+#include "MicroBenchmarks.h"
+#include "SyntheticLoadOrder.h"
+
+#include <cstdlib>
+#include <new>
+
+// Every allocation of the process is counted, so the planner's allocations can be read around a pass
+namespace
+{
+	std::atomic<std::uint64_t> allocationCount{ 0 };
+	std::atomic<std::uint64_t> allocationBytes{ 0 };
+
+	void* Allocate(std::size_t a_size, std::size_t a_alignment = alignof(std::max_align_t))
+	{
+		allocationCount.fetch_add(1, std::memory_order_relaxed);
+		allocationBytes.fetch_add(a_size, std::memory_order_relaxed);
+		if (a_size == 0) {
+			a_size = 1;
+		}
+#ifdef _WIN32
+		void* ptr = _aligned_malloc(a_size, a_alignment);
+#else
+		void* ptr = a_alignment <= alignof(std::max_align_t) ?
+		                std::malloc(a_size) :
+		                std::aligned_alloc(a_alignment, (a_size + a_alignment - 1) / a_alignment * a_alignment);
+#endif
+		if (!ptr) {
+			throw std::bad_alloc();
+		}
+		return ptr;
+	}
+
+	void Free(void* a_ptr) noexcept
+	{
+#ifdef _WIN32
+		_aligned_free(a_ptr);
+#else
+		std::free(a_ptr);
+#endif
+	}
+}
+
+void* operator new(std::size_t a_size) { return Allocate(a_size); }
+void* operator new[](std::size_t a_size) { return Allocate(a_size); }
+void* operator new(std::size_t a_size, std::align_val_t a_alignment) { return Allocate(a_size, static_cast<std::size_t>(a_alignment)); }
+void* operator new[](std::size_t a_size, std::align_val_t a_alignment) { return Allocate(a_size, static_cast<std::size_t>(a_alignment)); }
+void operator delete(void* a_ptr) noexcept { Free(a_ptr); }
+void operator delete[](void* a_ptr) noexcept { Free(a_ptr); }
+void operator delete(void* a_ptr, std::size_t) noexcept { Free(a_ptr); }
+void operator delete[](void* a_ptr, std::size_t) noexcept { Free(a_ptr); }
+void operator delete(void* a_ptr, std::align_val_t) noexcept { Free(a_ptr); }
+void operator delete[](void* a_ptr, std::align_val_t) noexcept { Free(a_ptr); }
+void operator delete(void* a_ptr, std::size_t, std::align_val_t) noexcept { Free(a_ptr); }
+void operator delete[](void* a_ptr, std::size_t, std::align_val_t) noexcept { Free(a_ptr); }
+
+namespace
+{
+	struct Scenario
+	{
+		std::string_view name;
+		SyntheticLoadOrderParams params;
+	};
+
+	// Phases the planner times, in the order they run
+	constexpr std::array PLANNER_PHASES = {
+		PhaseTimer::Phase::kIndexBuild,
+		PhaseTimer::Phase::kClassify,
+		PhaseTimer::Phase::kFormIDScan,
+		PhaseTimer::Phase::kFlipLoop,
+		PhaseTimer::Phase::kAssignFormID,
+		PhaseTimer::Phase::kExtraParts,
+	};
+
+	std::vector<Scenario> GetDefaultScenarios()
+	{
+		std::vector<Scenario> scenarios;
+		const auto add = [&](std::string_view a_name, auto a_configure) {
+			auto& scenario = scenarios.emplace_back(a_name);
+			a_configure(scenario.params);
+		};
+
+		add("baseline 10k", [](auto&) {});
+		add("large 100k", [](auto& a_params) { a_params.headPartCount = 100000; });
+		add("male only", [](auto& a_params) { a_params.maleShare = 1.0; a_params.femaleShare = 0.0; });
+		add("mostly genderless", [](auto& a_params) { a_params.maleShare = 0.1; a_params.femaleShare = 0.1; });
+		add("no extra parts", [](auto& a_params) { a_params.extraPartFanOut = 0; });
+		add("extra part fan-out 8", [](auto& a_params) { a_params.extraPartFanOut = 8; a_params.nestedExtraPartShare = 0.75; });
+		add("all ESP", [](auto& a_params) { a_params.lightPluginShare = 0.0; });
+		add("all ESL", [](auto& a_params) { a_params.pluginCount = 64; a_params.lightPluginShare = 1.0; });
+		add("no conflicts", [](auto& a_params) { a_params.conflictDensity = 0.0; });
+		add("dense conflicts", [](auto& a_params) { a_params.conflictDensity = 0.9; });
+		return scenarios;
+	}
+
+	// Parse "--key value" overrides into a single custom scenario
+	std::optional<Scenario> ParseArguments(std::span<char* const> a_args, std::uint32_t& a_iterations)
+	{
+		if (a_args.empty()) {
+			return std::nullopt;
+		}
+
+		Scenario scenario{ "custom", {} };
+		auto& params = scenario.params;
+		for (std::size_t i = 0; i + 1 < a_args.size(); i += 2) {
+			const std::string_view key = a_args[i];
+			const std::string_view value = a_args[i + 1];
+			const auto asDouble = [&] { return std::stod(std::string(value)); };
+			const auto asUInt = [&] { return static_cast<std::uint32_t>(std::stoul(std::string(value))); };
+			if (key == "--count") {
+				params.headPartCount = asUInt();
+			} else if (key == "--male") {
+				params.maleShare = asDouble();
+			} else if (key == "--female") {
+				params.femaleShare = asDouble();
+			} else if (key == "--fanout") {
+				params.extraPartFanOut = asUInt();
+			} else if (key == "--nested") {
+				params.nestedExtraPartShare = asDouble();
+			} else if (key == "--plugins") {
+				params.pluginCount = asUInt();
+			} else if (key == "--light") {
+				params.lightPluginShare = asDouble();
+			} else if (key == "--conflicts") {
+				params.conflictDensity = asDouble();
+			} else if (key == "--seed") {
+				params.seed = asUInt();
+			} else if (key == "--iterations") {
+				a_iterations = (std::max)(asUInt(), 1u);
+			} else {
+				fmt::print(stderr, "Unknown option {}\n", key);
+			}
+		}
+		return scenario;
+	}
+
+	void RunScenario(const Scenario& a_scenario, std::uint32_t a_iterations)
+	{
+		const auto source = MakeSyntheticLoadOrder(a_scenario.params);
+
+		std::array<HeadPartClassifier::TypeToggles, HeadPartClassifier::TYPE_COUNT> toggles{};
+		toggles.fill({ true, true });
+		HeadPartClassifier classifier;
+		classifier.Build(toggles);
+		const HeadPartRules rules;
+
+		PhaseTimer phaseTimer;
+		std::uint64_t allocations = 0;
+		std::uint64_t bytes = 0;
+		std::size_t plannedCount = 0;
+		int conflictCount = 0;
+		for (std::uint32_t i = 0; i < a_iterations; ++i) {
+			GenerationPlanner::Options options;
+			options.classifier = &classifier;
+			options.rules = &rules;
+			options.hashMode = FormIDUtils::HashMode::kStable;
+
+			const auto allocationsBefore = allocationCount.load();
+			const auto bytesBefore = allocationBytes.load();
+			{
+				GenerationReport report;
+				GenerationPlanner planner(*source, std::move(options));
+				planner.Plan(phaseTimer, &report);
+				plannedCount = planner.GetPlan().headParts.size();
+				conflictCount = planner.GetStats().formIDConflictCount;
+			}
+			allocations += allocationCount.load() - allocationsBefore;
+			bytes += allocationBytes.load() - bytesBefore;
+		}
+
+		fmt::print("{} ({} head parts, {} planned, {} FormID conflicts)\n",
+			a_scenario.name, source->GetHeadParts().size(), plannedCount, conflictCount);
+		for (const auto phase : PLANNER_PHASES) {
+			if (phaseTimer.GetCount(phase) > 0) {
+				fmt::print("  {:<24}{:>10.3f} ms\n", PhaseTimer::GetPhaseName(phase), phaseTimer.GetMilliseconds(phase) / a_iterations);
+			}
+		}
+		fmt::print("  {:<24}{:>10} ({:.1f} KiB)\n\n", "Allocations",
+			allocations / a_iterations, static_cast<double>(bytes) / a_iterations / 1024.0);
+	}
+}
+
+// Plans synthetic load orders and prints the average time per planner phase and allocations per pass
+// Without arguments a fixed set of scenarios and the micro-benchmarks run; "--key value" options describe a single scenario
+int main(int a_argc, char* a_argv[])
+{
+	spdlog::set_level(spdlog::level::warn);
+
+	std::uint32_t iterations = 5;
+	const auto custom = ParseArguments(std::span(a_argv, a_argc).subspan(1), iterations);
+	const auto scenarios = custom ? std::vector{ *custom } : GetDefaultScenarios();
+	for (const auto& scenario : scenarios) {
+		RunScenario(scenario, iterations);
+	}
+	if (!custom) {
+		RunMicroBenchmarks(iterations);
+	}
+	return 0;
+}
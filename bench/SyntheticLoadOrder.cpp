@@ -0,0 +1,130 @@
+#include "SyntheticLoadOrder.h"
+#include "CorePCH.h"
+#include "EditorIDIndex.h"
+#include "FormIDUtils.h"
+
+#include <random>
+
+namespace
+{
+	// Light plugins share their 2048 FormIDs with the parts flipped into them
+	constexpr std::uint32_t MAX_LIGHT_PLUGIN_PARTS = 512;
+
+	constexpr std::array HEAD_PART_TYPES = {
+		HeadPartType::kHair,
+		HeadPartType::kHair,
+		HeadPartType::kHair,
+		HeadPartType::kFacialHair,
+		HeadPartType::kEyebrows,
+		HeadPartType::kScar,
+		HeadPartType::kFace,
+		HeadPartType::kEyes,
+	};
+
+	bool HasExtraParts(HeadPartType a_type)
+	{
+		return a_type == HeadPartType::kHair || a_type == HeadPartType::kFacialHair ||
+		       a_type == HeadPartType::kEyebrows || a_type == HeadPartType::kScar;
+	}
+
+	// Hands out local FormIDs, moving parts to full plugins once a light plugin is full
+	class PluginAllocator
+	{
+	public:
+		PluginAllocator(MemoryHeadPartSource& a_source, const SyntheticLoadOrderParams& a_params)
+		{
+			const auto lightCount = static_cast<std::uint32_t>(a_params.pluginCount * a_params.lightPluginShare);
+			for (std::uint32_t i = 0; i < (std::max)(a_params.pluginCount, 1u); ++i) {
+				const bool isLight = i < lightCount && i + 1 < a_params.pluginCount;
+				plugins_.push_back({ a_source.AddPlugin(fmt::format("Synthetic{:03}.{}", i, isLight ? "esl" : "esp"), isLight), 0 });
+			}
+		}
+
+		std::pair<const PluginInfo*, std::uint32_t> Next(std::mt19937& a_random)
+		{
+			auto index = std::uniform_int_distribution<std::size_t>(0, plugins_.size() - 1)(a_random);
+			while (plugins_[index].plugin->isLight && plugins_[index].used >= MAX_LIGHT_PLUGIN_PARTS) {
+				index = (index + 1) % plugins_.size();
+			}
+			auto& entry = plugins_[index];
+			return { entry.plugin, FormIDUtils::FORMID_MIN + entry.used++ };
+		}
+
+	private:
+		struct Entry
+		{
+			const PluginInfo* plugin;
+			std::uint32_t used;
+		};
+
+		std::vector<Entry> plugins_;
+	};
+}
+
+std::unique_ptr<MemoryHeadPartSource> MakeSyntheticLoadOrder(const SyntheticLoadOrderParams& a_params)
+{
+	auto source = std::make_unique<MemoryHeadPartSource>();
+	std::mt19937 random(a_params.seed);
+	std::uniform_real_distribution<double> chance(0.0, 1.0);
+	PluginAllocator allocator(*source, a_params);
+	StringArena names;
+
+	const auto pickGender = [&]() -> std::uint8_t {
+		const auto roll = chance(random);
+		if (roll < a_params.maleShare) {
+			return std::to_underlying(HeadPartFlag::kMale);
+		}
+		if (roll < a_params.maleShare + a_params.femaleShare) {
+			return std::to_underlying(HeadPartFlag::kFemale);
+		}
+		return 0;
+	};
+
+	// Plant a form at the FormID the flipped part would hash to
+	const auto plantConflict = [&](std::string_view a_editorID, const PluginInfo* a_plugin) {
+		if (chance(random) < a_params.conflictDensity) {
+			const auto localID = FormIDUtils::GenerateBaseFormID(MakeUnisexyEditorID(a_editorID, names), a_plugin->isLight, FormIDUtils::HashMode::kStable);
+			source->AddForm(FormIDUtils::MakeFormID(a_plugin->compileIndex, a_plugin->isLight, localID), "Conflict");
+		}
+	};
+
+	// Extra parts are shared between head parts, so the resolver's memo is exercised
+	std::vector<FormID> extraParts;
+	if (a_params.extraPartFanOut > 0) {
+		const auto poolSize = (std::max)(a_params.headPartCount / 8, 1u);
+		for (std::uint32_t i = 0; i < poolSize; ++i) {
+			const auto [plugin, localID] = allocator.Next(random);
+			const auto editorID = fmt::format("SyntheticExtra{:06}", i);
+			extraParts.push_back(source->AddHeadPart(plugin, localID, editorID, HeadPartType::kMisc, pickGender()));
+			plantConflict(editorID, plugin);
+		}
+		for (std::size_t i = 0; i + 1 < extraParts.size(); ++i) {
+			if (chance(random) < a_params.nestedExtraPartShare) {
+				const auto nested = std::uniform_int_distribution<std::size_t>(i + 1, extraParts.size() - 1)(random);
+				source->AddExtraPart(extraParts[i], extraParts[nested]);
+			}
+		}
+	}
+
+	for (std::uint32_t i = 0; i < a_params.headPartCount; ++i) {
+		const auto [plugin, localID] = allocator.Next(random);
+		const auto type = HEAD_PART_TYPES[i % HEAD_PART_TYPES.size()];
+		const auto gender = pickGender();
+		const auto editorID = fmt::format("Synthetic{}{:06}", GetHeadPartTypeName(type), i);
+		const auto formID = source->AddHeadPart(plugin, localID, editorID, type,
+			static_cast<std::uint8_t>(std::to_underlying(HeadPartFlag::kPlayable) | gender));
+		if (gender != 0) {
+			plantConflict(editorID, plugin);
+		}
+
+		if (HasExtraParts(type) && !extraParts.empty()) {
+			for (std::uint32_t j = 0; j < a_params.extraPartFanOut; ++j) {
+				const auto extraPart = extraParts[std::uniform_int_distribution<std::size_t>(0, extraParts.size() - 1)(random)];
+				source->AddExtraPart(formID, extraPart);
+			}
+		}
+	}
+
+	source->Finalize();
+	return source;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "MemoryHeadPartSource.h"
+
+// Parameters of a generated load order
+struct SyntheticLoadOrderParams
+{
+	std::uint32_t headPartCount = 10000;  // Playable head parts, extra parts not included
+	double maleShare = 0.45;              // Share of male head parts
+	double femaleShare = 0.45;            // Share of female head parts; the rest are genderless
+	std::uint32_t extraPartFanOut = 2;    // Extra parts per hair, facial hair, scar and brow part
+	double nestedExtraPartShare = 0.25;   // Share of extra parts that have an extra part of their own
+	std::uint32_t pluginCount = 16;       // Plugins providing head parts
+	double lightPluginShare = 0.5;        // Share of those plugins that are light
+	double conflictDensity = 0.1;         // Share of flipped parts whose hashed FormID is already taken
+	std::uint32_t seed = 1;
+};
+
+// Build an in-memory load order with the given shape
+// Conflicts are planted at the FormIDs the stable hash derives for the flipped EditorIDs
+std::unique_ptr<MemoryHeadPartSource> MakeSyntheticLoadOrder(const SyntheticLoadOrderParams& a_params);
@@ -0,0 +1,29 @@
+set(core_headers ${core_headers}
+	src/CorePCH.h
+	src/EditorIDIndex.h
+	src/ExtraPartResolver.h
+	src/FormIDBitmap.h
+	src/FormIDManager.h
+	src/FormIDUtils.h
+	src/GenerationCacheFormat.h
+	src/GenerationPlan.h
+	src/GenerationPlanner.h
+	src/GenerationReport.h
+	src/GlobMatcher.h
+	src/Hash.h
+	src/HeadPartClassifier.h
+	src/HeadPartRules.h
+	src/HeadPartSource.h
+	src/MemoryHeadPartSource.h
+	src/PhaseTimer.h
+	src/StringArena.h
+)
+set(core_sources ${core_sources}
+	src/EditorIDIndex.cpp
+	src/ExtraPartResolver.cpp
+	src/FormIDManager.cpp
+	src/GenerationCacheFormat.cpp
+	src/GenerationPlanner.cpp
+	src/GenerationReport.cpp
+	src/MemoryHeadPartSource.cpp
+)
@@ -1,7 +1,10 @@
 set(headers ${headers}
-	src/FormIDManager.h
+	src/GameHeadPartSource.h
+	src/GenerationCache.h
 	src/HeadPartUtils.h
 	src/PCH.h
+	src/RaceRemapper.h
 	src/Settings.h
+	src/SettingsWatcher.h
 	src/Unisexy.h
 )
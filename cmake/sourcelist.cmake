@@ -1,8 +1,11 @@
 set(sources ${sources}
-	src/FormIDManager.cpp
+	src/GameHeadPartSource.cpp
+	src/GenerationCache.cpp
 	src/HeadPartUtils.cpp
 	src/PCH.cpp
+	src/RaceRemapper.cpp
 	src/Settings.cpp
+	src/SettingsWatcher.cpp
 	src/Unisexy.cpp
 	src/main.cpp
 )
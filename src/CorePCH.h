@@ -0,0 +1,47 @@
+#pragma once
+
+// Precompiled header of the engine-independent core library, its tests and benchmark
+// Unlike PCH.h it pulls in nothing from CommonLibSSE or SKSE, so the core builds with any toolchain
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <bitset>
+#include <cassert>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <execution>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
+#include <set>
+#include <span>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+using namespace std::literals;
+
+// Core code logs through spdlog's default logger, which the plugin points at its log file
+namespace logger
+{
+	using spdlog::debug;
+	using spdlog::error;
+	using spdlog::info;
+	using spdlog::warn;
+}
@@ -0,0 +1,36 @@
+#include "EditorIDIndex.h"
+#include "CorePCH.h"
+
+void EditorIDIndex::Build(const IHeadPartSource& a_source)
+{
+	const auto headParts = a_source.GetHeadParts();
+
+	headParts_.clear();
+	// Leave room for the parts created during this pass to avoid rehashing
+	headParts_.reserve(headParts.size() + headParts.size() / 2);
+
+	for (const auto& headPart : headParts) {
+		if (!headPart.editorID.empty()) {
+			Insert(Hash::HashedKey(headPart.editorID), headPart.formID);
+		}
+	}
+}
+
+FormID EditorIDIndex::Find(const Hash::HashedKey& a_editorID) const
+{
+	const auto it = headParts_.find(a_editorID);
+	return it != headParts_.end() ? it->second : 0;
+}
+
+bool EditorIDIndex::Contains(const Hash::HashedKey& a_editorID) const
+{
+	return headParts_.contains(a_editorID);
+}
+
+void EditorIDIndex::Insert(const Hash::HashedKey& a_editorID, FormID a_formID)
+{
+	if (a_editorID.str.empty()) {
+		return;
+	}
+	headParts_.try_emplace(a_editorID, a_formID);
+}
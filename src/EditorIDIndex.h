@@ -0,0 +1,36 @@
+#pragma once
+
+#include "Hash.h"
+#include "HeadPartSource.h"
+#include "StringArena.h"
+
+// Append the Unisexy suffix to an EditorID, stored in the arena and hashed once
+inline Hash::HashedKey MakeUnisexyEditorID(std::string_view a_editorID, StringArena& a_arena)
+{
+	return Hash::HashedKey(a_arena.Concat(a_editorID, "_Unisexy"sv));
+}
+
+// EditorID -> head part FormID hash index used to detect duplicates and reuse
+// already created or planned Unisexy parts without rescanning the form array
+class EditorIDIndex
+{
+public:
+	// Index every head part of the source
+	void Build(const IHeadPartSource& a_source);
+
+	// Returns the FormID of the head part registered under the given EditorID, or 0 if none
+	FormID Find(const Hash::HashedKey& a_editorID) const;
+
+	// Check if a head part with the given EditorID exists
+	bool Contains(const Hash::HashedKey& a_editorID) const;
+
+	// Record a head part registered with the data handler or planned for creation
+	// Keeps the first head part if the EditorID is already indexed
+	// The EditorID is not copied and must outlive the index
+	void Insert(const Hash::HashedKey& a_editorID, FormID a_formID);
+
+private:
+	// Keys view the source's EditorIDs or the generation pass's string arena
+	// and carry their hash, so lookups never rehash the string
+	std::unordered_map<Hash::HashedKey, FormID, Hash::HashedKeyHash> headParts_;
+};
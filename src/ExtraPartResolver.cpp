@@ -0,0 +1,183 @@
+#include "ExtraPartResolver.h"
+#include "CorePCH.h"
+
+namespace
+{
+	std::string_view GetEditorIDOrPlaceholder(const HeadPartRecord* a_headPart)
+	{
+		return a_headPart->editorID.empty() ? "NoEditorID"sv : a_headPart->editorID;
+	}
+}
+
+ExtraPartResolver::ExtraPartResolver(
+	FormIDManager& a_formIDManager,
+	EditorIDIndex& a_editorIDIndex,
+	StringArena& a_arena,
+	bool a_verboseLogging,
+	GenerationPlan& a_plan,
+	std::vector<std::tuple<std::string_view, std::uint32_t, std::uint32_t>>& a_conflictDetails) :
+	formIDManager_(a_formIDManager),
+	editorIDIndex_(a_editorIDIndex),
+	arena_(a_arena),
+	plan_(a_plan),
+	conflictDetails_(a_conflictDetails),
+	verboseLogging_(a_verboseLogging)
+{}
+
+void ExtraPartResolver::Resolve(
+	const HeadPartRecord* a_sourcePart,
+	bool a_toFemale,
+	const PluginInfo* a_targetFile,
+	std::vector<FormID>& a_outExtraParts)
+{
+	// All parameters should be valid from caller
+	assert(a_sourcePart && a_targetFile);
+
+	// Early exit if no extra parts to process
+	const auto& extraParts = a_sourcePart->extraParts;
+	if (extraParts.empty()) {
+		return;
+	}
+
+	if (verboseLogging_) {
+		logger::info("Planning {} extra parts for head part {} [{:08X}]",
+			extraParts.size(), GetEditorIDOrPlaceholder(a_sourcePart), a_sourcePart->formID);
+	}
+
+	// Assign every direct extra part its FormID first, in order, as older builds did
+	directFrames_.clear();
+	for (const auto* extraPart : extraParts) {
+		if (!extraPart) {
+			if (verboseLogging_) {
+				logger::warn("Null extra part found in source head part {} [{:08X}]",
+					GetEditorIDOrPlaceholder(a_sourcePart), a_sourcePart->formID);
+			}
+			continue;
+		}
+
+		if (const auto it = resolved_.find({ extraPart->formID, a_toFemale }); it != resolved_.end()) {
+			memoHits_++;
+			a_outExtraParts.push_back(it->second);
+		} else {
+			a_outExtraParts.push_back(Visit(extraPart, a_toFemale, a_targetFile, true));
+		}
+	}
+
+	// Then walk below each of them in turn
+	for (auto& frame : directFrames_) {
+		frame.resolvedBegin = resolvedExtraParts_.size();
+		stack_.push_back(frame);
+		ResolveStack(a_toFemale, a_targetFile);
+	}
+}
+
+void ExtraPartResolver::ResolveStack(bool a_toFemale, const PluginInfo* a_targetFile)
+{
+	// Resolve nested extra parts depth first; a part is planned once all of its extra parts are
+	while (!stack_.empty()) {
+		maxDepth_ = (std::max)(maxDepth_, stack_.size());
+
+		auto& frame = stack_.back();
+		const auto& nestedParts = frame.source->extraParts;
+		if (frame.nextExtraPart < nestedParts.size()) {
+			const auto* nestedPart = nestedParts[frame.nextExtraPart++];
+			if (!nestedPart) {
+				continue;
+			}
+
+			if (const auto it = resolved_.find({ nestedPart->formID, a_toFemale }); it != resolved_.end()) {
+				memoHits_++;
+				resolvedExtraParts_.push_back(it->second);
+			} else if (stack_.size() >= MAX_DEPTH) {
+				logger::warn("Extra part chain of {} is deeper than {} levels, keeping [{:08X}] as is",
+					frame.editorID, MAX_DEPTH, nestedPart->formID);
+				resolvedExtraParts_.push_back(nestedPart->formID);
+			} else {
+				// Take the slot first so a pushed frame's extra parts start after it
+				// Visit may push a frame and invalidate the reference to this one
+				const auto slot = resolvedExtraParts_.size();
+				resolvedExtraParts_.push_back(0);
+				resolvedExtraParts_[slot] = Visit(nestedPart, a_toFemale, a_targetFile, false);
+			}
+			continue;
+		}
+
+		plan_.Add(frame.source->formID, frame.formID, frame.editorID, a_toFemale,
+			std::span(resolvedExtraParts_).subspan(frame.resolvedBegin)).legacyFormID = frame.legacyFormID;
+		resolvedExtraParts_.resize(frame.resolvedBegin);
+
+		if (verboseLogging_) {
+			logger::info("Planned extra part: {} [{:08X}] (Type: {}) from source [{:08X}]",
+				frame.editorID, frame.formID,
+				GetHeadPartTypeName(frame.source->type),
+				frame.source->formID);
+		}
+		stack_.pop_back();
+	}
+}
+
+FormID ExtraPartResolver::Visit(const HeadPartRecord* a_extraPart, bool a_toFemale, const PluginInfo* a_targetFile, bool a_isDirect)
+{
+	const Key key{ a_extraPart->formID, a_toFemale };
+
+	// Analyze extra part gender compatibility; genderless parts and parts of the target gender are kept
+	const bool extraIsMale = a_extraPart->HasFlag(HeadPartFlag::kMale);
+	const bool extraIsFemale = a_extraPart->HasFlag(HeadPartFlag::kFemale);
+	const bool needsGenderFlip = (extraIsMale && a_toFemale) || (extraIsFemale && !a_toFemale);
+
+	if (!needsGenderFlip) {
+		if (verboseLogging_) {
+			logger::debug("Using original extra part: {} [{:08X}] (Type: {})",
+				GetEditorIDOrPlaceholder(a_extraPart), a_extraPart->formID,
+				GetHeadPartTypeName(a_extraPart->type));
+		}
+		resolved_.emplace(key, a_extraPart->formID);
+		return a_extraPart->formID;
+	}
+
+	// Generate EditorID for gender-flipped extra part
+	Hash::HashedKey newEditorKey;
+	if (!a_extraPart->editorID.empty()) {
+		newEditorKey = MakeUnisexyEditorID(a_extraPart->editorID, arena_);
+	} else {
+		std::array<char, 32> buffer{};
+		const auto result = fmt::format_to_n(buffer.data(), buffer.size(), "ExtraPart_{:08X}_Unisexy", a_extraPart->formID);
+		newEditorKey = Hash::HashedKey(arena_.Intern(std::string_view(buffer.data(), result.size)));
+	}
+	const auto newEditorID = newEditorKey.str;
+
+	// Reuse the extra part if it already exists, for example from an earlier generation
+	if (const auto existingFormID = editorIDIndex_.Find(newEditorKey)) {
+		if (verboseLogging_) {
+			logger::info("Reusing existing extra part: {} [{:08X}]", newEditorID, existingFormID);
+		}
+		resolved_.emplace(key, existingFormID);
+		return existingFormID;
+	}
+
+	// Reserve a FormID for the gender-flipped extra part
+	// Older builds only flipped the direct extra parts of a head part, right after the part itself
+	std::uint32_t conflictFormID = 0;
+	const auto newFormID = formIDManager_.AssignFormID(newEditorKey, a_targetFile, conflictFormID);
+	const auto legacyFormID = a_isDirect ? formIDManager_.AssignLegacyFormID(newEditorKey, a_targetFile) : 0;
+	if (!newFormID) {
+		// Fall back to original extra part if no FormID is available
+		conflictDetails_.emplace_back(newEditorID, conflictFormID, 0);
+		logger::error("Failed to assign FormID for extra part {} [{:08X}]", newEditorID, a_extraPart->formID);
+		resolved_.emplace(key, a_extraPart->formID);
+		return a_extraPart->formID;
+	}
+
+	// Store conflict details if there was a conflict
+	if (conflictFormID != 0) {
+		conflictDetails_.emplace_back(newEditorID, conflictFormID, newFormID);
+	}
+
+	// Memoize before descending so a cycle back to this part resolves to the part being planned
+	resolved_.emplace(key, newFormID);
+	editorIDIndex_.Insert(newEditorKey, newFormID);
+
+	// Nested extra parts are flipped to the same gender and planned before the part that uses them
+	(a_isDirect ? directFrames_ : stack_).push_back({ a_extraPart, newFormID, legacyFormID, newEditorID, 0, resolvedExtraParts_.size() });
+	return newFormID;
+}
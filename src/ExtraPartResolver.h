@@ -0,0 +1,99 @@
+#pragma once
+
+#include "EditorIDIndex.h"
+#include "FormIDManager.h"
+#include "GenerationPlan.h"
+#include "HeadPartSource.h"
+#include "StringArena.h"
+
+// Resolves the extra parts of flipped head parts for a whole generation pass
+// Each (extra part, target gender) pair is resolved once and memoized, so an extra part
+// shared by many head parts is planned once, and nested extra parts are flipped as well
+// The extra part graph is walked with an explicit stack, bounded in depth; the memo doubles
+// as the visited set for the whole pass, so cycles terminate and no part is walked twice
+// The direct extra parts of a head part take their FormIDs before any nested part does, in the
+// order older builds assigned them, so flipping nested parts can't shift the FormIDs saves refer to
+class ExtraPartResolver
+{
+public:
+	// New EditorIDs are stored in a_arena, which must outlive the plan, index and conflict details
+	ExtraPartResolver(
+		FormIDManager& a_formIDManager,
+		EditorIDIndex& a_editorIDIndex,
+		StringArena& a_arena,
+		bool a_verboseLogging,
+		GenerationPlan& a_plan,
+		std::vector<std::tuple<std::string_view, std::uint32_t, std::uint32_t>>& a_conflictDetails);
+
+	// Plan gender-flipped versions of a source head part's extra parts
+	// Flipped extra parts are added to the plan; nothing is created until the plan is instantiated
+	// New FormIDs are taken from a_targetFile; a shared extra part lives in the plugin of the first head part that needs it
+	// Appends the FormIDs the new head part should use as extra parts to a_outExtraParts
+	void Resolve(
+		const HeadPartRecord* a_sourcePart,
+		bool a_toFemale,
+		const PluginInfo* a_targetFile,
+		std::vector<FormID>& a_outExtraParts);
+
+	// Number of unique (extra part, target gender) pairs resolved
+	std::size_t GetResolvedCount() const { return resolved_.size(); }
+	// Number of extra part lookups answered by an earlier resolution
+	std::size_t GetMemoHitCount() const { return memoHits_; }
+	// Deepest extra part chain walked
+	std::size_t GetMaxDepth() const { return maxDepth_; }
+
+	// Nested extra parts below this depth are kept as they are
+	static constexpr std::size_t MAX_DEPTH = 16;
+
+private:
+	struct Key
+	{
+		FormID formID;
+		bool toFemale;
+
+		bool operator==(const Key&) const = default;
+	};
+
+	struct KeyHash
+	{
+		std::size_t operator()(const Key& a_key) const noexcept
+		{
+			return std::hash<std::uint64_t>{}((static_cast<std::uint64_t>(a_key.formID) << 1) | a_key.toFemale);
+		}
+	};
+
+	// A flipped extra part whose own extra parts are being resolved
+	struct Frame
+	{
+		const HeadPartRecord* source;
+		FormID formID;
+		FormID legacyFormID;
+		std::string_view editorID;
+		std::uint32_t nextExtraPart;
+		std::size_t resolvedBegin;  // Start of its resolved extra parts in resolvedExtraParts_
+	};
+
+	// Walk and plan every unresolved extra part below the frames on the stack, until it is empty
+	void ResolveStack(bool a_toFemale, const PluginInfo* a_targetFile);
+
+	// Resolve an extra part that isn't memoized yet
+	// A flipped part is memoized right away; its frame, which resolves its own extra parts,
+	// is queued in directFrames_ for a direct extra part and pushed onto the stack otherwise
+	FormID Visit(const HeadPartRecord* a_extraPart, bool a_toFemale, const PluginInfo* a_targetFile, bool a_isDirect);
+
+	FormIDManager& formIDManager_;
+	EditorIDIndex& editorIDIndex_;
+	StringArena& arena_;
+	GenerationPlan& plan_;
+	std::vector<std::tuple<std::string_view, std::uint32_t, std::uint32_t>>& conflictDetails_;
+	bool verboseLogging_;
+
+	std::unordered_map<Key, FormID, KeyHash> resolved_;
+	std::size_t memoHits_ = 0;
+	std::size_t maxDepth_ = 0;
+
+	// Traversal scratch space, reused across head parts
+	std::vector<Frame> directFrames_;
+	std::vector<Frame> stack_;
+	std::vector<FormID> resolvedExtraParts_;
+};
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "FormIDUtils.h"
+
+// Occupancy bitmap over one plugin's local FormID space
+// Pages are allocated on first write, so a full plugin's 16 Mbit range only
+// costs memory around IDs that are actually taken; a light plugin fits in one page
+class FormIDBitmap
+{
+public:
+	explicit FormIDBitmap(bool a_isLight) :
+		maxLocalID_(FormIDUtils::GetMaxLocalID(a_isLight)),
+		pages_((maxLocalID_ >> PAGE_SHIFT) + 1)
+	{}
+
+	// Check if a local FormID is taken
+	bool Test(std::uint32_t a_localID) const
+	{
+		const auto& page = pages_[a_localID >> PAGE_SHIFT];
+		return page && ((*page)[(a_localID & PAGE_MASK) >> 6] & (std::uint64_t{ 1 } << (a_localID & 63))) != 0;
+	}
+
+	// Mark a local FormID as taken
+	void Set(std::uint32_t a_localID)
+	{
+		auto& page = pages_[a_localID >> PAGE_SHIFT];
+		if (!page) {
+			page = std::make_unique<Page>();
+		}
+		(*page)[(a_localID & PAGE_MASK) >> 6] |= std::uint64_t{ 1 } << (a_localID & 63);
+	}
+
+	// Find the highest free local FormID at or below a_start, wrapping around to the top of the range
+	// Returns std::nullopt once every ID from FORMID_MIN up is taken
+	std::optional<std::uint32_t> FindFree(std::uint32_t a_start) const
+	{
+		if (a_start > maxLocalID_ || a_start < FormIDUtils::FORMID_MIN) {
+			a_start = maxLocalID_;
+		}
+		if (const auto localID = FindFreeBelow(a_start, FormIDUtils::FORMID_MIN)) {
+			return localID;
+		}
+		if (a_start < maxLocalID_) {
+			return FindFreeBelow(maxLocalID_, a_start + 1);
+		}
+		return std::nullopt;
+	}
+
+private:
+	static constexpr std::uint32_t PAGE_SHIFT = 12;  // 4 Kbit pages, one page covers a light plugin
+	static constexpr std::uint32_t PAGE_MASK = (1u << PAGE_SHIFT) - 1;
+	using Page = std::array<std::uint64_t, (1u << PAGE_SHIFT) / 64>;
+
+	// Highest free ID in [a_low, a_high], scanning a 64-bit word at a time
+	std::optional<std::uint32_t> FindFreeBelow(std::uint32_t a_high, std::uint32_t a_low) const
+	{
+		if (a_high < a_low) {
+			return std::nullopt;
+		}
+
+		std::uint32_t localID = a_high;
+		while (true) {
+			const auto& page = pages_[localID >> PAGE_SHIFT];
+			if (!page) {
+				return localID;  // Untouched page, everything in it is free
+			}
+
+			const std::uint32_t wordBase = localID & ~63u;
+			std::uint64_t free = ~(*page)[(localID & PAGE_MASK) >> 6];
+			// Ignore IDs above the scan position and below the lower bound
+			if ((localID & 63) != 63) {
+				free &= (std::uint64_t{ 2 } << (localID & 63)) - 1;
+			}
+			if (wordBase < a_low) {
+				free &= ~std::uint64_t{ 0 } << (a_low - wordBase);
+			}
+			if (free) {
+				return wordBase + static_cast<std::uint32_t>(std::bit_width(free)) - 1;
+			}
+
+			if (wordBase <= a_low) {
+				return std::nullopt;
+			}
+			localID = wordBase - 1;
+		}
+	}
+
+	std::uint32_t maxLocalID_;
+	std::vector<std::unique_ptr<Page>> pages_;
+};
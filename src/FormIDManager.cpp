@@ -1,147 +1,144 @@
 #include "FormIDManager.h"
-#include "Settings.h"
+#include "CorePCH.h"
 
-namespace
-{
-	// Constants for FormID generation and conflict handling
-	constexpr std::uint32_t FORMID_MIN = 0x800;        // Minimum valid FormID
-	constexpr std::uint32_t MAX_FORMID_ATTEMPTS = 10;  // Maximum attempts to resolve FormID conflicts
-
-	// ESL (Light Plugin) constants
-	constexpr std::uint32_t ESL_FLAG = 0xFE000000;        // FormID flag for ESL plugins
-	constexpr std::uint32_t ESL_HIGH_START = 0xFFF;       // Starting FormID for ESL (counts down)
-	constexpr std::uint32_t ESL_INDEX_MASK = 0x00FFF000;  // Mask for ESL index (bits 12-23)
-	constexpr std::uint32_t ESL_INDEX_SHIFT = 12;         // Bit shift for ESL index
-
-	// ESP/ESM (Full Plugin) constants
-	constexpr std::uint32_t ESP_HIGH_START = 0xFFFFFF;    // Starting FormID for ESP/ESM (counts down)
-	constexpr std::uint32_t ESP_INDEX_MASK = 0xFF000000;  // Mask for ESP/ESM index (bits 24-31)
-	constexpr std::uint32_t ESP_INDEX_SHIFT = 24;         // Bit shift for ESP/ESM index
-
-	// Generate a deterministic FormID based on EditorID
-	std::uint32_t GenerateBaseFormID(const std::string& editorID, bool isLight)
-	{
-		std::hash<std::string> hasher;
-		size_t hash = hasher(editorID);
-		std::uint32_t maxFormID = isLight ? ESL_HIGH_START : ESP_HIGH_START;
-		std::uint32_t range = maxFormID - FORMID_MIN + 1;
-		return maxFormID - (static_cast<std::uint32_t>(hash % range));
-	}
-}
-
-FormIDManager::FormIDManager() = default;
+FormIDManager::FormIDManager(const IHeadPartSource& source, FormIDUtils::HashMode hashMode, bool verboseLogging) :
+	source_(source),
+	hashMode_(hashMode),
+	verboseLogging_(verboseLogging)
+{}
 
-bool FormIDManager::AssignFormID(RE::TESForm* form, const RE::TESFile* targetFile, std::uint32_t& outConflictFormID)
+FormID FormIDManager::AssignFormID(const Hash::HashedKey& editorID, const PluginInfo* targetFile, std::uint32_t& outConflictFormID)
 {
 	// Validate input parameters
-	if (!form || !targetFile) {
-		logger::error("Invalid form or target file provided for FormID assignment.");
-		return false;
+	if (!targetFile) {
+		logger::error("Invalid target file provided for FormID assignment.");
+		return 0;
 	}
 
-	const char* editorID = form->GetFormEditorID();
-	if (!editorID || editorID[0] == '\0') {
-		logger::error("No EditorID for form in plugin: {}", targetFile->GetFilename());
-		return false;
+	if (editorID.str.empty()) {
+		logger::error("No EditorID for form in plugin: {}", targetFile->fileName);
+		return 0;
 	}
 
 	// Initialize plugin properties and tracking
-	const bool isLight = targetFile->IsLight();
-	const bool verboseLogging = Settings::GetSingleton()->IsVerboseLogging();
-	auto& assignedIDs = assignedFormIDs_[targetFile];
+	const bool isLight = targetFile->isLight;
+	const std::uint32_t fileIndex = targetFile->compileIndex;
+	auto& occupancy = GetOccupancy(targetFile);
+	outConflictFormID = 0;  // Initialize output conflict FormID
 
 	// Generate initial FormID based on EditorID
-	std::uint32_t counter = GenerateBaseFormID(editorID, isLight);
-	if (verboseLogging) {
-		logger::info("Generated FormID counter {:04X} for '{}'", counter, editorID);
+	const std::uint32_t counter = FormIDUtils::GenerateBaseFormID(editorID, isLight, hashMode_);
+	if (verboseLogging_) {
+		logger::info("Generated FormID counter {:04X} for '{}'", counter, editorID.str);
 	}
 
-	std::uint32_t newFormID = 0;
-	std::uint32_t attemptCount = 0;
-	outConflictFormID = 0;  // Initialize output conflict FormID
+	// Take the hashed FormID if it's free, otherwise the next free one counting down
+	const auto localID = occupancy.FindFree(counter);
+	if (!localID) {
+		if (isLight) {
+			logger::error("Exhausted ESL FormID range for plugin: {}", targetFile->fileName);
+		} else {
+			logger::error("Exhausted ESP/ESM FormID range for plugin: {}", targetFile->fileName);
+		}
+		outConflictFormID = FormIDUtils::MakeFormID(fileIndex, isLight, counter);
+		return 0;
+	}
 
-	// Attempt to assign a unique FormID
-	while (attemptCount < MAX_FORMID_ATTEMPTS) {
-		// Ensure FormID is within valid range
-		if (counter < FORMID_MIN) {
-			if (isLight) {
-				logger::error("Exhausted ESL FormID range for plugin: {}", targetFile->GetFilename());
-			} else {
-				logger::error("Exhausted ESP/ESM FormID range for plugin: {}", targetFile->GetFilename());
-			}
-			return false;
+	if (*localID != counter) {
+		outConflictFormID = FormIDUtils::MakeFormID(fileIndex, isLight, counter);
+		if (verboseLogging_) {
+			const auto existingEditorID = source_.GetEditorID(outConflictFormID);
+			const auto conflictEditorID = existingEditorID.empty() ? "Unknown"sv : existingEditorID;
+			logger::warn("FormID conflict {:08X}: Used by form '{}' in plugin: {}",
+				outConflictFormID, conflictEditorID, targetFile->fileName);
 		}
+	}
 
-		// Construct FormID based on plugin type
-		if (isLight) {
-			newFormID = ESL_FLAG |
-			            ((static_cast<std::uint32_t>(targetFile->smallFileCompileIndex) << ESL_INDEX_SHIFT) | counter);
-		} else {
-			newFormID = ((static_cast<std::uint32_t>(targetFile->compileIndex) << ESP_INDEX_SHIFT) | counter);
+	const std::uint32_t newFormID = FormIDUtils::MakeFormID(fileIndex, isLight, *localID);
+	occupancy.Set(*localID);
+	if (verboseLogging_) {
+		logger::info("Assigned FormID {:08X} to '{}' in plugin '{}'",
+			newFormID, editorID.str, targetFile->fileName);
+		if (outConflictFormID != 0) {
+			logger::info("Resolved conflict for FormID {:08X} by assigning {:08X}",
+				outConflictFormID, newFormID);
 		}
+	}
+	return newFormID;
+}
 
-		// Validate constructed FormID
-		if (newFormID == 0) {
-			logger::error("Generated invalid FormID 0 for plugin: {}", targetFile->GetFilename());
-			return false;
+FormID FormIDManager::AssignLegacyFormID(const Hash::HashedKey& editorID, const PluginInfo* targetFile)
+{
+	if (hashMode_ != FormIDUtils::HashMode::kMigrate || !targetFile || editorID.str.empty()) {
+		return 0;
+	}
+
+	// Older builds created each form as soon as it had a FormID, so their probes also hit the forms they created earlier
+	const bool isLight = targetFile->isLight;
+	std::uint32_t counter = FormIDUtils::GenerateLegacyBaseFormID(editorID.str, isLight);
+	for (std::uint32_t attempt = 0; attempt < MAX_LEGACY_ATTEMPTS && counter >= FormIDUtils::FORMID_MIN; ++attempt, --counter) {
+		const auto formID = FormIDUtils::MakeFormID(targetFile->compileIndex, isLight, counter);
+		if (legacyFormIDs_.contains(formID)) {
+			continue;
 		}
+		const auto probeFormID = FormIDUtils::GetLegacyProbeFormID(formID, targetFile->compileIndex, isLight);
+		if (!source_.HasForm(probeFormID) && !legacyFormIDs_.contains(probeFormID)) {
+			legacyFormIDs_.insert(formID);
+			return formID;
+		}
+	}
 
-		// Check for conflicts within the target plugin
-		bool isAvailable = assignedIDs.find(newFormID) == assignedIDs.end();
-		if (isAvailable) {
-			// Verify with data handler for existing forms in the target plugin
-			auto* existingForm = RE::TESDataHandler::GetSingleton()->LookupForm(newFormID, targetFile->GetFilename());
-			if (!existingForm) {
-				form->SetFormID(newFormID, false);
-				assignedIDs.insert(newFormID);
-				if (verboseLogging) {
-					logger::info("Assigned FormID {:08X} to '{}' in plugin '{}'",
-						newFormID, editorID, targetFile->GetFilename());
-					if (outConflictFormID != 0) {
-						logger::info("Resolved conflict for FormID {:08X} by assigning {:08X}",
-							outConflictFormID, newFormID);
-					}
-				}
-				return true;
-			}
-
-			// Log conflict with existing form in target plugin
-			outConflictFormID = newFormID;
-			if (verboseLogging) {
-				const char* conflictEditorID = existingForm->GetFormEditorID() ? existingForm->GetFormEditorID() : "Unknown";
-				logger::warn("FormID conflict {:08X} (Attempt {}/{}): Used by form '{}' (Type: {}) in plugin: {}",
-					newFormID, attemptCount + 1, MAX_FORMID_ATTEMPTS,
-					conflictEditorID, existingForm->GetObjectTypeName(), targetFile->GetFilename());
-			}
+	if (verboseLogging_) {
+		logger::info("Older builds assigned no FormID to '{}' in plugin '{}'", editorID.str, targetFile->fileName);
+	}
+	return 0;
+}
+
+void FormIDManager::SeedOccupancy(std::span<const PluginInfo* const> targetFiles)
+{
+	// Map compile indices straight to the bitmaps being seeded
+	std::vector<FormIDBitmap*> fullFiles((FormIDUtils::ESP_INDEX_MASK >> FormIDUtils::ESP_INDEX_SHIFT) + 1);
+	std::vector<FormIDBitmap*> lightFiles((FormIDUtils::ESL_INDEX_MASK >> FormIDUtils::ESL_INDEX_SHIFT) + 1);
+	std::size_t fileCount = 0;
+	for (const auto* targetFile : targetFiles) {
+		if (!targetFile || occupancy_.contains(targetFile)) {
+			continue;
+		}
+
+		auto& occupancy = occupancy_.try_emplace(targetFile, targetFile->isLight).first->second;
+		if (targetFile->isLight) {
+			lightFiles[targetFile->compileIndex] = &occupancy;
 		} else {
-			// Log conflict with previously assigned FormID
-			outConflictFormID = newFormID;
-			if (verboseLogging) {
-				logger::warn("FormID {:08X} already assigned in plugin: {} (Attempt {}/{})",
-					newFormID, targetFile->GetFilename(), attemptCount + 1, MAX_FORMID_ATTEMPTS);
-			}
+			fullFiles[targetFile->compileIndex] = &occupancy;
 		}
+		fileCount++;
+	}
 
-		// Fallback: decrement counter for deterministic conflict resolution
-		counter--;
-		attemptCount++;
+	if (fileCount == 0) {
+		return;
 	}
 
-	logger::error("Failed to assign FormID for '{}' in plugin '{}' after {} attempts",
-		editorID, targetFile->GetFilename(), MAX_FORMID_ATTEMPTS);
-	return false;
+	std::size_t seededCount = 0;
+	source_.ForEachFormID([&](FormID a_formID) {
+		const auto fileIndex = FormIDUtils::GetFileIndex(a_formID);
+		auto* occupancy = FormIDUtils::IsLightFormID(a_formID) ? lightFiles[fileIndex] : fullFiles[fileIndex];
+		if (occupancy) {
+			occupancy->Set(FormIDUtils::GetLocalID(a_formID));
+			seededCount++;
+		}
+	});
+
+	if (verboseLogging_) {
+		logger::info("Indexed {} occupied FormIDs across {} target plugins", seededCount, fileCount);
+	}
 }
 
-const RE::TESFile* GetFileFromFormID(std::uint32_t formID)
+FormIDBitmap& FormIDManager::GetOccupancy(const PluginInfo* targetFile)
 {
-	auto& dataHandler = *RE::TESDataHandler::GetSingleton();
-	if ((formID & ESL_FLAG) == ESL_FLAG) {
-		// Resolve ESL plugin from FormID
-		const std::uint16_t smallIndex = static_cast<std::uint16_t>((formID & ESL_INDEX_MASK) >> ESL_INDEX_SHIFT);
-		return dataHandler.LookupLoadedLightModByIndex(smallIndex);
-	} else {
-		// Resolve ESP/ESM plugin from FormID
-		const std::uint8_t index = static_cast<std::uint8_t>((formID & ESP_INDEX_MASK) >> ESP_INDEX_SHIFT);
-		return dataHandler.LookupLoadedModByIndex(index);
+	if (const auto it = occupancy_.find(targetFile); it != occupancy_.end()) {
+		return it->second;
 	}
+
+	SeedOccupancy(std::span(&targetFile, 1));
+	return occupancy_.at(targetFile);
 }
@@ -1,24 +1,45 @@
 #pragma once
 
-#include "RE/Skyrim.h"
+#include "FormIDBitmap.h"
+#include "FormIDUtils.h"
+#include "HeadPartSource.h"
 
 class FormIDManager
 {
 public:
-	FormIDManager();
+	FormIDManager(const IHeadPartSource& source, FormIDUtils::HashMode hashMode, bool verboseLogging);
 
-	// Assign a unique FormID to the given form within the target plugin's namespace
-	// Returns false if assignment fails due to conflicts or invalid inputs
-	// Sets outConflictFormID to the conflicting FormID if a conflict occurs
-	bool AssignFormID(RE::TESForm* form, const RE::TESFile* targetFile, std::uint32_t& outConflictFormID);
+	// Reserve a unique FormID derived from an EditorID within the target plugin's namespace
+	// Returns 0 if the plugin's FormID range is exhausted or inputs are invalid
+	// Sets outConflictFormID to the hashed FormID if it was taken and another one was reserved
+	FormID AssignFormID(const Hash::HashedKey& editorID, const PluginInfo* targetFile, std::uint32_t& outConflictFormID);
+
+	// Replay the FormID an older build assigned to the same EditorID in the target plugin
+	// Older builds counted down from the legacy hash for at most MAX_LEGACY_ATTEMPTS IDs without wrapping,
+	// skipping IDs they had assigned earlier in the pass and IDs whose probe (see GetLegacyProbeFormID) hit a form
+	// Call in the order they assigned them
+	// Returns 0 outside Migrate hash mode or if the older build found no FormID
+	FormID AssignLegacyFormID(const Hash::HashedKey& editorID, const PluginInfo* targetFile);
+
+	// Index the FormIDs already taken in the given plugins with a single pass over the source's forms
+	// Plugins that were not pre-scanned are scanned on their first assignment instead
+	void SeedOccupancy(std::span<const PluginInfo* const> targetFiles);
 
 private:
-	// Current FormID counter per plugin
-	std::map<const RE::TESFile*, std::uint32_t> formCounts_;
-	// Track assigned FormIDs per plugin to prevent conflicts
-	std::map<const RE::TESFile*, std::set<std::uint32_t>> assignedFormIDs_;
-};
+	// Attempts older builds made before giving up on a FormID
+	static constexpr std::uint32_t MAX_LEGACY_ATTEMPTS = 10;
+
+	// Get the occupancy of a plugin's FormIDs, seeding it on first use
+	FormIDBitmap& GetOccupancy(const PluginInfo* targetFile);
 
-// Utility function to determine which plugin file a FormID belongs to
-// Returns nullptr if the FormID doesn't correspond to a loaded plugin
-const RE::TESFile* GetFileFromFormID(std::uint32_t formID);
+	const IHeadPartSource& source_;
+	// Hash used to derive FormIDs, fixed for the lifetime of the manager
+	FormIDUtils::HashMode hashMode_;
+	bool verboseLogging_;
+
+	// FormIDs taken by loaded forms or assigned by this manager, per plugin
+	std::unordered_map<const PluginInfo*, FormIDBitmap> occupancy_;
+
+	// FormIDs replayed by AssignLegacyFormID, which older builds had created forms with by the time of each probe
+	std::unordered_set<FormID> legacyFormIDs_;
+};
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "Hash.h"
+
+// FormID layout and derivation helpers
+// Kept free of engine types so the FormID planning math can be reasoned about on its own
+namespace FormIDUtils
+{
+	// Constants for FormID generation
+	inline constexpr std::uint32_t FORMID_MIN = 0x800;  // Minimum valid local FormID
+
+	// ESL (Light Plugin) constants
+	inline constexpr std::uint32_t ESL_FLAG = 0xFE000000;        // FormID flag for ESL plugins
+	inline constexpr std::uint32_t ESL_HIGH_START = 0xFFF;       // Starting FormID for ESL (counts down)
+	inline constexpr std::uint32_t ESL_INDEX_MASK = 0x00FFF000;  // Mask for ESL index (bits 12-23)
+	inline constexpr std::uint32_t ESL_INDEX_SHIFT = 12;         // Bit shift for ESL index
+
+	// ESP/ESM (Full Plugin) constants
+	inline constexpr std::uint32_t ESP_HIGH_START = 0xFFFFFF;    // Starting FormID for ESP/ESM (counts down)
+	inline constexpr std::uint32_t ESP_INDEX_MASK = 0xFF000000;  // Mask for ESP/ESM index (bits 24-31)
+	inline constexpr std::uint32_t ESP_INDEX_SHIFT = 24;         // Bit shift for ESP/ESM index
+
+	// Highest local FormID available in a plugin
+	constexpr std::uint32_t GetMaxLocalID(bool a_isLight)
+	{
+		return a_isLight ? ESL_HIGH_START : ESP_HIGH_START;
+	}
+
+	// Check if a full FormID belongs to a light plugin
+	constexpr bool IsLightFormID(std::uint32_t a_formID)
+	{
+		return (a_formID & ESL_FLAG) == ESL_FLAG;
+	}
+
+	// Combine a plugin compile index and a local FormID into a full FormID
+	constexpr std::uint32_t MakeFormID(std::uint32_t a_fileIndex, bool a_isLight, std::uint32_t a_localID)
+	{
+		if (a_isLight) {
+			return ESL_FLAG | (a_fileIndex << ESL_INDEX_SHIFT) | (a_localID & ESL_HIGH_START);
+		}
+		return (a_fileIndex << ESP_INDEX_SHIFT) | (a_localID & ESP_HIGH_START);
+	}
+
+	// Extract the plugin compile index from a full FormID
+	constexpr std::uint32_t GetFileIndex(std::uint32_t a_formID)
+	{
+		return IsLightFormID(a_formID) ?
+		           (a_formID & ESL_INDEX_MASK) >> ESL_INDEX_SHIFT :
+		           (a_formID & ESP_INDEX_MASK) >> ESP_INDEX_SHIFT;
+	}
+
+	// Extract the local FormID from a full FormID
+	constexpr std::uint32_t GetLocalID(std::uint32_t a_formID)
+	{
+		return a_formID & GetMaxLocalID(IsLightFormID(a_formID));
+	}
+
+	// FormID older builds looked up to check whether a full FormID was free
+	// They passed it to TESDataHandler::LookupForm, which adds the plugin's index bits a second time,
+	// so only plugins at compile index 0 were checked where intended
+	constexpr std::uint32_t GetLegacyProbeFormID(std::uint32_t a_formID, std::uint32_t a_fileIndex, bool a_isLight)
+	{
+		const std::uint32_t indexBits = a_isLight ? ESL_FLAG + (a_fileIndex << ESL_INDEX_SHIFT) : a_fileIndex << ESP_INDEX_SHIFT;
+		return indexBits + a_formID;  // Wraps around like the 32-bit sum it replays
+	}
+
+	// Hash used to derive FormIDs from EditorIDs
+	enum class HashMode : std::uint32_t
+	{
+		kLegacy,   // std::hash, as in older builds; varies between toolchains
+		kStable,   // FNV-1a, identical across builds
+		kMigrate,  // FNV-1a, with the FormIDs older builds assigned kept as aliases for existing saves
+	};
+
+	// Map a hash onto the local FormID range, counting down from the top
+	constexpr std::uint32_t HashToLocalID(std::uint64_t a_hash, bool a_isLight)
+	{
+		const std::uint32_t maxFormID = GetMaxLocalID(a_isLight);
+		const std::uint32_t range = maxFormID - FORMID_MIN + 1;
+		return maxFormID - static_cast<std::uint32_t>(a_hash % range);
+	}
+
+	// Local FormID derived the way older builds did, with the implementation-defined std::hash
+	inline std::uint32_t GenerateLegacyBaseFormID(std::string_view a_editorID, bool a_isLight)
+	{
+		// std::hash<std::string_view> matches std::hash<std::string> for the same characters
+		return HashToLocalID(std::hash<std::string_view>{}(a_editorID), a_isLight);
+	}
+
+	// Local FormID derived from a stable hash of the EditorID
+	constexpr std::uint32_t GenerateStableBaseFormID(std::string_view a_editorID, bool a_isLight)
+	{
+		return HashToLocalID(Hash::FNV1a(a_editorID), a_isLight);
+	}
+
+	// Generate a deterministic local FormID based on EditorID
+	// The stable derivation reuses the key's precomputed hash
+	inline std::uint32_t GenerateBaseFormID(const Hash::HashedKey& a_editorID, bool a_isLight, HashMode a_mode)
+	{
+		return a_mode == HashMode::kLegacy ?
+		           GenerateLegacyBaseFormID(a_editorID.str, a_isLight) :
+		           HashToLocalID(a_editorID.hash, a_isLight);
+	}
+
+	static_assert(MakeFormID(0x01, false, 0x123456) == 0x01123456);
+	static_assert(MakeFormID(0x002, true, 0xABC) == 0xFE002ABC);
+	static_assert(GetFileIndex(0xFE002ABC) == 0x002 && GetLocalID(0xFE002ABC) == 0xABC);
+	static_assert(GetFileIndex(0x01123456) == 0x01 && GetLocalID(0x01123456) == 0x123456);
+	static_assert(GetLegacyProbeFormID(0x00123456, 0x00, false) == 0x00123456);
+	static_assert(GetLegacyProbeFormID(0x05123456, 0x05, false) == 0x0A123456);
+	static_assert(GetLegacyProbeFormID(0x90123456, 0x90, false) == 0x20123456);
+	static_assert(GetLegacyProbeFormID(0xFE002ABC, 0x002, true) == 0xFC004ABC);
+
+	// Stable FormIDs must never change between builds; saves reference them
+	static_assert(GenerateStableBaseFormID("HairMaleNord01_Unisexy", false) == 0x41D21B);
+	static_assert(GenerateStableBaseFormID("HairMaleNord01_Unisexy", true) == 0xA1B);
+	static_assert(GenerateStableBaseFormID("HairFemaleImperial1_Unisexy", false) == 0xA394EE);
+	static_assert(GenerateStableBaseFormID("HairFemaleImperial1_Unisexy", true) == 0xCEE);
+	static_assert(GenerateStableBaseFormID("BrowsMaleHumanoid05_Unisexy", false) == 0x998130);
+	static_assert(GenerateStableBaseFormID("BrowsMaleHumanoid05_Unisexy", true) == 0x930);
+}
@@ -0,0 +1,124 @@
+#include "GameHeadPartSource.h"
+#include "PCH.h"
+
+// The core mirrors the engine's head part enums
+static_assert(std::to_underlying(HeadPartType::kTotal) == std::to_underlying(RE::BGSHeadPart::HeadPartType::kTotal));
+static_assert(std::to_underlying(HeadPartType::kHair) == std::to_underlying(RE::BGSHeadPart::HeadPartType::kHair));
+static_assert(std::to_underlying(HeadPartType::kEyebrows) == std::to_underlying(RE::BGSHeadPart::HeadPartType::kEyebrows));
+static_assert(std::to_underlying(HeadPartFlag::kPlayable) == std::to_underlying(RE::BGSHeadPart::Flag::kPlayable));
+static_assert(std::to_underlying(HeadPartFlag::kMale) == std::to_underlying(RE::BGSHeadPart::Flag::kMale));
+static_assert(std::to_underlying(HeadPartFlag::kFemale) == std::to_underlying(RE::BGSHeadPart::Flag::kFemale));
+
+GameHeadPartSource::GameHeadPartSource(RE::TESDataHandler& a_dataHandler)
+{
+	const auto& headParts = a_dataHandler.GetFormArray<RE::BGSHeadPart>();
+
+	// Reserved up front so records never move while they are linked
+	headParts_.reserve(headParts.size());
+	records_.reserve(headParts.size());
+	recordsByID_.reserve(headParts.size());
+	pendingRecords_.reserve(headParts.size());
+	for (const auto* headPart : headParts) {
+		if (headPart && !records_.contains(headPart)) {
+			auto& record = headParts_.emplace_back();
+			Snapshot(record, headPart);
+		}
+	}
+
+	// Wire extra parts; extra parts missing from the form array are snapshotted on the way
+	std::vector<std::pair<std::uint32_t, std::uint32_t>> ranges;  // Begin, count in extraParts_
+	ranges.reserve(pendingRecords_.size());
+	for (std::size_t i = 0; i < pendingRecords_.size(); ++i) {
+		const auto* headPart = pendingRecords_[i].second;
+		const auto begin = static_cast<std::uint32_t>(extraParts_.size());
+		for (const auto* extraPart : headPart->extraParts) {
+			extraParts_.push_back(extraPart ? GetRecord(extraPart) : nullptr);
+		}
+		ranges.emplace_back(begin, static_cast<std::uint32_t>(extraParts_.size()) - begin);
+	}
+	for (std::size_t i = 0; i < pendingRecords_.size(); ++i) {
+		pendingRecords_[i].first->extraParts = std::span(extraParts_).subspan(ranges[i].first, ranges[i].second);
+	}
+	pendingRecords_ = {};
+}
+
+std::span<const HeadPartRecord> GameHeadPartSource::GetHeadParts() const
+{
+	return headParts_;
+}
+
+const HeadPartRecord* GameHeadPartSource::FindHeadPart(FormID a_formID) const
+{
+	const auto it = recordsByID_.find(a_formID);
+	return it != recordsByID_.end() ? it->second : nullptr;
+}
+
+void GameHeadPartSource::ForEachFormID(const std::function<void(FormID)>& a_visitor) const
+{
+	auto [allForms, lock] = RE::TESForm::GetAllForms();
+	RE::BSReadLockGuard locker{ lock };
+	for (const auto& entry : *allForms) {
+		a_visitor(entry.first);
+	}
+}
+
+bool GameHeadPartSource::HasForm(FormID a_formID) const
+{
+	return RE::TESForm::LookupByID(a_formID) != nullptr;
+}
+
+std::string_view GameHeadPartSource::GetEditorID(FormID a_formID) const
+{
+	const auto* form = RE::TESForm::LookupByID(a_formID);
+	const char* editorID = form ? form->GetFormEditorID() : nullptr;
+	return editorID ? editorID : std::string_view{};
+}
+
+const PluginInfo* GameHeadPartSource::FindPlugin(const RE::TESFile* a_file) const
+{
+	const auto it = pluginsByFile_.find(a_file);
+	return it != pluginsByFile_.end() ? it->second : nullptr;
+}
+
+const PluginInfo* GameHeadPartSource::GetPlugin(const RE::TESFile* a_file)
+{
+	if (!a_file) {
+		return nullptr;
+	}
+	if (const auto* plugin = FindPlugin(a_file)) {
+		return plugin;
+	}
+
+	auto& plugin = plugins_.emplace_back();
+	plugin.fileName = a_file->GetFilename();
+	plugin.isLight = a_file->IsLight();
+	plugin.compileIndex = plugin.isLight ? a_file->smallFileCompileIndex : a_file->compileIndex;
+	pluginsByFile_.emplace(a_file, &plugin);
+	return &plugin;
+}
+
+const HeadPartRecord* GameHeadPartSource::GetRecord(const RE::BGSHeadPart* a_headPart)
+{
+	if (const auto it = records_.find(a_headPart); it != records_.end()) {
+		return it->second;
+	}
+
+	auto& record = detachedParts_.emplace_back();
+	Snapshot(record, a_headPart);
+	return &record;
+}
+
+void GameHeadPartSource::Snapshot(HeadPartRecord& a_record, const RE::BGSHeadPart* a_headPart)
+{
+	const char* editorID = a_headPart->GetFormEditorID();
+	a_record.formID = a_headPart->formID;
+	a_record.editorID = editorID ? editorID : std::string_view{};
+	a_record.type = static_cast<HeadPartType>(a_headPart->type.underlying());
+	a_record.flags = a_headPart->flags.underlying();
+	a_record.file = GetPlugin(a_headPart->GetFile());
+	a_record.originFile = GetPlugin(a_headPart->GetFile(0));
+
+	records_.emplace(a_headPart, &a_record);
+	recordsByID_.emplace(a_record.formID, &a_record);
+	pendingRecords_.emplace_back(&a_record, a_headPart);
+}
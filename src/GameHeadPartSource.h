@@ -0,0 +1,41 @@
+#pragma once
+
+#include "HeadPartSource.h"
+#include "RE/Skyrim.h"
+
+// Snapshot of the data handler's head parts for a generation pass
+// Taken once on the main thread; the planner only reads the snapshot and the global form map
+class GameHeadPartSource : public IHeadPartSource
+{
+public:
+	explicit GameHeadPartSource(RE::TESDataHandler& a_dataHandler);
+
+	std::span<const HeadPartRecord> GetHeadParts() const override;
+	const HeadPartRecord* FindHeadPart(FormID a_formID) const override;
+	void ForEachFormID(const std::function<void(FormID)>& a_visitor) const override;
+	bool HasForm(FormID a_formID) const override;
+	std::string_view GetEditorID(FormID a_formID) const override;
+
+	// Plugin info of a loaded plugin that provides or defines a head part, or nullptr
+	const PluginInfo* FindPlugin(const RE::TESFile* a_file) const;
+
+private:
+	// Plugin info of a loaded plugin, created on first use
+	const PluginInfo* GetPlugin(const RE::TESFile* a_file);
+
+	// Record of a head part, creating a detached one if it isn't in the form array
+	const HeadPartRecord* GetRecord(const RE::BGSHeadPart* a_headPart);
+
+	// Fill a record from its head part; extra parts are wired once every record exists
+	void Snapshot(HeadPartRecord& a_record, const RE::BGSHeadPart* a_headPart);
+
+	std::deque<PluginInfo> plugins_;
+	std::unordered_map<const RE::TESFile*, const PluginInfo*> pluginsByFile_;
+
+	std::vector<HeadPartRecord> headParts_;                                          // Form array order
+	std::deque<HeadPartRecord> detachedParts_;                                       // Extra parts missing from the form array
+	std::vector<std::pair<HeadPartRecord*, const RE::BGSHeadPart*>> pendingRecords_;  // Records whose extra parts are unwired
+	std::unordered_map<const RE::BGSHeadPart*, const HeadPartRecord*> records_;
+	std::unordered_map<FormID, const HeadPartRecord*> recordsByID_;
+	std::vector<const HeadPartRecord*> extraParts_;  // Extra parts of all records, back to back
+};
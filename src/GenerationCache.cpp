@@ -0,0 +1,187 @@
+#include "GenerationCache.h"
+#include "ExtraPartResolver.h"
+#include "Hash.h"
+#include "HeadPartUtils.h"
+#include "PCH.h"
+
+namespace
+{
+	// Mix the parts of a head part record that decide what gets generated from it
+	void HashHeadPart(Hash::Hasher& a_hasher, const RE::BGSHeadPart* a_headPart)
+	{
+		const char* editorID = a_headPart->GetFormEditorID();
+		a_hasher.Update(std::string_view(editorID ? editorID : ""));
+		a_hasher.Update(a_headPart->type.get());
+		a_hasher.Update(a_headPart->flags.underlying());
+	}
+
+	// Find a loaded plugin by name, full or light
+	const RE::TESFile* LookupLoadedFile(RE::TESDataHandler& a_dataHandler, std::string_view a_fileName)
+	{
+		if (const auto* file = a_dataHandler.LookupLoadedModByName(a_fileName)) {
+			return file;
+		}
+		return a_dataHandler.LookupLoadedLightModByName(a_fileName);
+	}
+}
+
+std::uint64_t GenerationCache::ComputeKey(const Settings& a_settings)
+{
+	Hash::Hasher hasher;
+	hasher.Update(GenerationCacheFormat::VERSION);
+	hasher.Update(Version::NAME);
+	hasher.Update(a_settings.GetHash());
+	return hasher.Get();
+}
+
+std::vector<PluginFingerprint> GenerationCache::ComputeFingerprints(RE::TESDataHandler& a_dataHandler)
+{
+	// Group head parts by the plugin that provides their winning record, which is also where their flipped versions go
+	std::unordered_map<const RE::TESFile*, Hash::Hasher> hashers;
+
+	// Nested extra parts are flipped too, so cover every extra part the resolver can reach
+	// The walk matches the resolver's: depth first, bounded by its depth limit, each part once per head part
+	std::vector<std::pair<const RE::BGSHeadPart*, std::size_t>> stack;
+	std::unordered_set<const RE::BGSHeadPart*> visited;
+	for (const auto* headPart : a_dataHandler.GetFormArray<RE::BGSHeadPart>()) {
+		const auto* file = headPart ? headPart->GetFile() : nullptr;
+		if (!file) {
+			continue;
+		}
+
+		auto& hasher = hashers[file];
+		HashHeadPart(hasher, headPart);
+		if (headPart->extraParts.empty()) {
+			continue;
+		}
+
+		visited.clear();
+		visited.insert(headPart);
+		stack.emplace_back(headPart, 0);
+		while (!stack.empty()) {
+			const auto [part, depth] = stack.back();
+			stack.pop_back();
+			if (part != headPart) {
+				HashHeadPart(hasher, part);
+			}
+			if (depth >= ExtraPartResolver::MAX_DEPTH) {
+				continue;
+			}
+
+			// Pushed in reverse so extra parts are hashed in order
+			const auto& extraParts = part->extraParts;
+			for (auto i = extraParts.size(); i > 0; --i) {
+				const auto* extraPart = extraParts[i - 1];
+				if (extraPart && visited.insert(extraPart).second) {
+					stack.emplace_back(extraPart, depth + 1);
+				}
+			}
+		}
+	}
+
+	std::vector<PluginFingerprint> fingerprints;
+	fingerprints.reserve(hashers.size());
+	const auto addFingerprint = [&](const RE::TESFile* a_file) {
+		const auto it = a_file ? hashers.find(a_file) : hashers.end();
+		if (it == hashers.end()) {
+			return;
+		}
+
+		Hash::Hasher hasher;
+		hasher.Update(a_file->GetFilename());
+		hasher.Update(a_file->IsLight());
+		hasher.Update(it->second.Get());
+		fingerprints.push_back({ a_file->GetFilename(), hasher.Get() });
+	};
+
+	for (const auto* file : a_dataHandler.compiledFileCollection.files) {
+		addFingerprint(file);
+	}
+	for (const auto* file : a_dataHandler.compiledFileCollection.smallFiles) {
+		addFingerprint(file);
+	}
+
+	return fingerprints;
+}
+
+void GenerationCache::Open()
+{
+	const auto cachePath = GetCachePath();
+
+	std::error_code ec;
+	if (!std::filesystem::exists(cachePath, ec) || std::filesystem::file_size(cachePath, ec) < GenerationCacheFormat::HEADER_SIZE) {
+		return;
+	}
+
+	try {
+		_mapping = boost::interprocess::file_mapping(cachePath.c_str(), boost::interprocess::read_only);
+		_region = boost::interprocess::mapped_region(_mapping, boost::interprocess::read_only);
+	} catch (const boost::interprocess::interprocess_exception& e) {
+		logger::error("Failed to map generation cache '{}': {}", cachePath, e.what());
+		Close();
+	}
+}
+
+void GenerationCache::Close()
+{
+	_region = boost::interprocess::mapped_region();
+	_mapping = boost::interprocess::file_mapping();
+}
+
+bool GenerationCache::Load(std::uint64_t a_key, GenerationCacheFormat::View& a_outView) const
+{
+	const auto* data = static_cast<const std::byte*>(_region.get_address());
+	const std::size_t size = _region.get_size();
+	if (!data || size < GenerationCacheFormat::HEADER_SIZE) {
+		logger::info("No generation cache found at {}", GetCachePath());
+		return false;
+	}
+
+	auto& dataHandler = *RE::TESDataHandler::GetSingleton();
+	const auto findPlugin = [&](std::string_view a_fileName) -> std::optional<PluginInfo> {
+		const auto* file = LookupLoadedFile(dataHandler, a_fileName);
+		if (!file) {
+			return std::nullopt;
+		}
+		const bool isLight = file->IsLight();
+		return PluginInfo{ a_fileName, isLight ? file->smallFileCompileIndex : file->compileIndex, isLight };
+	};
+	return a_outView.Open(std::span(data, size), a_key, findPlugin) == GenerationCacheFormat::DecodeResult::kOk;
+}
+
+void GenerationCache::Save(std::uint64_t a_key, const GenerationPlan& a_plan) const
+{
+	const auto getPluginName = [](FormID a_formID) -> std::string_view {
+		const auto* file = HeadPartUtils::GetFileFromFormID(a_formID);
+		return file ? file->GetFilename() : std::string_view{};
+	};
+	const auto buffer = GenerationCacheFormat::Encode(a_key, a_plan, getPluginName);
+
+	// Written next to the cache and renamed over it, so a crash mid-write leaves the previous cache intact
+	const auto cachePath = GetCachePath();
+	const auto tempPath = cachePath + ".tmp";
+	std::error_code ec;
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(buffer.size())) || !file.flush()) {
+			logger::error("Failed to write generation cache '{}'. Check file permissions.", cachePath);
+			file.close();
+			std::filesystem::remove(tempPath, ec);
+			return;
+		}
+	}
+
+	std::filesystem::rename(tempPath, cachePath, ec);
+	if (ec) {
+		logger::error("Failed to replace generation cache '{}': {}", cachePath, ec.message());
+		std::filesystem::remove(tempPath, ec);
+		return;
+	}
+
+	logger::info("Saved generation cache with {} head parts from {} plugins to {}", a_plan.headParts.size(), a_plan.plugins.size(), cachePath);
+}
+
+std::string GenerationCache::GetCachePath()
+{
+	return fmt::format("Data/SKSE/Plugins/{}.cache", Version::PROJECT);
+}
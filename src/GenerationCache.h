@@ -0,0 +1,45 @@
+#pragma once
+
+#include "GenerationCacheFormat.h"
+#include "Settings.h"
+#include <ClibUtil/singleton.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+// Persists the generation plan between launches so plugins whose head parts are
+// unchanged can have their generated parts recreated without regeneration
+// The file format lives in GenerationCacheFormat; this class maps the file and resolves plugins through the data handler
+class GenerationCache : public clib_util::singleton::ISingleton<GenerationCache>
+{
+public:
+	// Compute the cache key from the settings that affect generation
+	// Load order changes are handled per plugin through fingerprints instead
+	static std::uint64_t ComputeKey(const Settings& a_settings);
+
+	// Fingerprint every plugin that provides winning head part records, in load order
+	// Covers each record's EditorID, type and flags and those of every extra part it reaches, nested ones included
+	static std::vector<PluginFingerprint> ComputeFingerprints(RE::TESDataHandler& a_dataHandler);
+
+	// Memory-map the cache file if one exists
+	// Nothing is read or validated until Load is called
+	void Open();
+
+	// Release the mapping; views returned by Load and anything read through them must no longer be used
+	void Close();
+
+	// Open a view of the cached plan over the mapping; records are read in place, resolved against the current load order
+	// Only the header and plugin table are read here
+	// Returns false if there is no cache, it is invalid or it was written for a different key
+	bool Load(std::uint64_t a_key, GenerationCacheFormat::View& a_outView) const;
+
+	// Write the plan to the cache file, atomically replacing any previous cache
+	// Must not be called while the cache file is mapped
+	void Save(std::uint64_t a_key, const GenerationPlan& a_plan) const;
+
+private:
+	// Path of the cache file next to the INI
+	static std::string GetCachePath();
+
+	boost::interprocess::file_mapping _mapping;
+	boost::interprocess::mapped_region _region;
+};
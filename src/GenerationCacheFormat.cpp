@@ -0,0 +1,410 @@
+#include "GenerationCacheFormat.h"
+#include "CorePCH.h"
+#include "FormIDUtils.h"
+
+namespace GenerationCacheFormat
+{
+	namespace
+	{
+		constexpr std::uint32_t MAGIC = 0x58534E55;  // "UNSX"
+
+		// Plugin index of FormIDs that don't belong to a plugin; localID then holds the raw FormID
+		constexpr std::uint32_t NO_PLUGIN = 0xFFFFFFFF;
+
+		struct Header
+		{
+			std::uint32_t magic;
+			std::uint32_t version;
+			std::uint64_t key;
+			std::uint32_t pluginCount;
+			std::uint32_t partCount;
+			std::uint32_t extraCount;
+			std::uint32_t disabledCount;
+			std::uint32_t stringTableSize;
+			std::uint32_t reserved;
+		};
+		static_assert(sizeof(Header) == HEADER_SIZE);
+
+		struct PluginRecord
+		{
+			std::uint32_t nameOffset;   // Offset into the string table
+			std::uint16_t nameLength;   // Length without the NUL terminator
+			std::uint16_t reserved;
+			std::uint64_t fingerprint;  // 0 if the plugin provides no head parts
+		};
+		static_assert(sizeof(PluginRecord) == 0x10);
+
+		// A FormID as a plugin table index and a local FormID
+		struct FormRef
+		{
+			std::uint32_t pluginIndex;
+			std::uint32_t localID;
+		};
+		static_assert(sizeof(FormRef) == 0x8);
+
+		struct PartRecord
+		{
+			FormRef source;
+			FormRef formID;
+			FormRef legacyFormID;          // NO_PLUGIN and 0 if the part has none
+			std::uint32_t editorIDOffset;  // Offset into the string table
+			std::uint16_t editorIDLength;  // Length without the NUL terminator
+			std::uint16_t flags;           // PartFlag bits
+			std::uint32_t extraPartsBegin;
+			std::uint32_t extraPartsCount;
+		};
+		static_assert(sizeof(PartRecord) == 0x28);
+
+		enum PartFlag : std::uint16_t
+		{
+			kToFemale = 1 << 0
+		};
+
+		// Appends little-endian integers regardless of the host byte order
+		class Writer
+		{
+		public:
+			template <std::unsigned_integral T>
+			void Write(T a_value)
+			{
+				for (std::size_t i = 0; i < sizeof(T); ++i) {
+					buffer_.push_back(static_cast<std::byte>(a_value >> (i * 8)));
+				}
+			}
+
+			void Write(const FormRef& a_ref)
+			{
+				Write(a_ref.pluginIndex);
+				Write(a_ref.localID);
+			}
+
+			void WriteBytes(std::span<const std::byte> a_bytes) { buffer_.insert(buffer_.end(), a_bytes.begin(), a_bytes.end()); }
+
+			std::vector<std::byte>& GetBuffer() { return buffer_; }
+
+		private:
+			std::vector<std::byte> buffer_;
+		};
+
+		// Reads little-endian integers at absolute offsets
+		// Callers validate the section sizes against the data size before reading records
+		class Reader
+		{
+		public:
+			explicit Reader(std::span<const std::byte> a_data) :
+				data_(a_data)
+			{}
+
+			template <std::unsigned_integral T>
+			T Read(std::uint64_t a_offset) const
+			{
+				assert(a_offset + sizeof(T) <= data_.size());
+				T value = 0;
+				for (std::size_t i = 0; i < sizeof(T); ++i) {
+					value |= static_cast<T>(std::to_integer<T>(data_[a_offset + i]) << (i * 8));
+				}
+				return value;
+			}
+
+			FormRef ReadFormRef(std::uint64_t a_offset) const
+			{
+				return { Read<std::uint32_t>(a_offset), Read<std::uint32_t>(a_offset + 4) };
+			}
+
+		private:
+			std::span<const std::byte> data_;
+		};
+	}
+
+	std::vector<std::byte> Encode(std::uint64_t a_key, const GenerationPlan& a_plan, const GetPluginName& a_getPluginName)
+	{
+		std::string stringTable;
+		const auto addString = [&](std::string_view a_str) {
+			const auto offset = static_cast<std::uint32_t>(stringTable.size());
+			stringTable.append(a_str);
+			stringTable.push_back('\0');
+			return offset;
+		};
+
+		// Plugin table: fingerprinted plugins first, then any other plugin a FormID belongs to
+		std::vector<PluginRecord> plugins;
+		std::unordered_map<std::string_view, std::uint32_t> pluginIndices;
+		const auto addPlugin = [&](std::string_view a_fileName, std::uint64_t a_fingerprint) {
+			const auto [it, inserted] = pluginIndices.try_emplace(a_fileName, static_cast<std::uint32_t>(plugins.size()));
+			if (inserted) {
+				auto& record = plugins.emplace_back();
+				record.nameOffset = addString(a_fileName);
+				record.nameLength = static_cast<std::uint16_t>(a_fileName.size());
+				record.reserved = 0;
+				record.fingerprint = a_fingerprint;
+			}
+			return it->second;
+		};
+		for (const auto& [fileName, fingerprint] : a_plan.plugins) {
+			addPlugin(fileName, fingerprint);
+		}
+
+		const auto toRef = [&](FormID a_formID) -> FormRef {
+			const auto fileName = a_formID != 0 ? a_getPluginName(a_formID) : std::string_view{};
+			if (fileName.empty()) {
+				return { NO_PLUGIN, a_formID };
+			}
+			return { addPlugin(fileName, 0), FormIDUtils::GetLocalID(a_formID) };
+		};
+
+		std::vector<PartRecord> records;
+		records.reserve(a_plan.headParts.size());
+		for (const auto& planned : a_plan.headParts) {
+			auto& record = records.emplace_back();
+			record.source = toRef(planned.sourceFormID);
+			record.formID = toRef(planned.formID);
+			record.legacyFormID = toRef(planned.legacyFormID);
+			record.editorIDOffset = addString(planned.editorID);
+			record.editorIDLength = static_cast<std::uint16_t>(planned.editorID.size());
+			record.flags = static_cast<std::uint16_t>(planned.toFemale ? kToFemale : 0);
+			record.extraPartsBegin = planned.extraPartsBegin;
+			record.extraPartsCount = planned.extraPartsCount;
+		}
+
+		std::vector<FormRef> extraRefs;
+		extraRefs.reserve(a_plan.extraParts.size());
+		for (const auto formID : a_plan.extraParts) {
+			extraRefs.push_back(toRef(formID));
+		}
+		std::vector<FormRef> disabledRefs;
+		disabledRefs.reserve(a_plan.disabledParts.size());
+		for (const auto formID : a_plan.disabledParts) {
+			disabledRefs.push_back(toRef(formID));
+		}
+
+		Writer out;
+		out.GetBuffer().reserve(HEADER_SIZE + plugins.size() * sizeof(PluginRecord) + records.size() * sizeof(PartRecord) +
+								(extraRefs.size() + disabledRefs.size()) * sizeof(FormRef) + stringTable.size());
+		out.Write(MAGIC);
+		out.Write(VERSION);
+		out.Write(a_key);
+		out.Write(static_cast<std::uint32_t>(plugins.size()));
+		out.Write(static_cast<std::uint32_t>(records.size()));
+		out.Write(static_cast<std::uint32_t>(extraRefs.size()));
+		out.Write(static_cast<std::uint32_t>(disabledRefs.size()));
+		out.Write(static_cast<std::uint32_t>(stringTable.size()));
+		out.Write(std::uint32_t{ 0 });
+		for (const auto& plugin : plugins) {
+			out.Write(plugin.nameOffset);
+			out.Write(plugin.nameLength);
+			out.Write(plugin.reserved);
+			out.Write(plugin.fingerprint);
+		}
+		for (const auto& record : records) {
+			out.Write(record.source);
+			out.Write(record.formID);
+			out.Write(record.legacyFormID);
+			out.Write(record.editorIDOffset);
+			out.Write(record.editorIDLength);
+			out.Write(record.flags);
+			out.Write(record.extraPartsBegin);
+			out.Write(record.extraPartsCount);
+		}
+		for (const auto& ref : extraRefs) {
+			out.Write(ref);
+		}
+		for (const auto& ref : disabledRefs) {
+			out.Write(ref);
+		}
+		out.WriteBytes(std::as_bytes(std::span(stringTable)));
+		return std::move(out.GetBuffer());
+	}
+
+	DecodeResult View::Open(std::span<const std::byte> a_data, std::uint64_t a_key, const FindPlugin& a_findPlugin)
+	{
+		*this = {};
+		if (a_data.size() < HEADER_SIZE) {
+			logger::error("Generation cache is truncated or corrupted. Ignoring it.");
+			return DecodeResult::kCorrupted;
+		}
+
+		// Validate the header and section sizes; records are checked as they are read
+		const Reader in(a_data);
+		Header header{};
+		header.magic = in.Read<std::uint32_t>(0x00);
+		header.version = in.Read<std::uint32_t>(0x04);
+		header.key = in.Read<std::uint64_t>(0x08);
+		header.pluginCount = in.Read<std::uint32_t>(0x10);
+		header.partCount = in.Read<std::uint32_t>(0x14);
+		header.extraCount = in.Read<std::uint32_t>(0x18);
+		header.disabledCount = in.Read<std::uint32_t>(0x1C);
+		header.stringTableSize = in.Read<std::uint32_t>(0x20);
+
+		if (header.magic != MAGIC || header.version != VERSION) {
+			logger::info("Generation cache has an unsupported format (version {}). Ignoring it.", header.version);
+			return DecodeResult::kUnsupported;
+		}
+		if (header.key != a_key) {
+			logger::info("Generation cache is out of date (settings changed).");
+			return DecodeResult::kOutOfDate;
+		}
+
+		const std::uint64_t pluginsOffset = HEADER_SIZE;
+		const std::uint64_t partsOffset = pluginsOffset + std::uint64_t{ header.pluginCount } * sizeof(PluginRecord);
+		const std::uint64_t extrasOffset = partsOffset + std::uint64_t{ header.partCount } * sizeof(PartRecord);
+		const std::uint64_t disabledOffset = extrasOffset + std::uint64_t{ header.extraCount } * sizeof(FormRef);
+		const std::uint64_t stringsOffset = disabledOffset + std::uint64_t{ header.disabledCount } * sizeof(FormRef);
+		if (stringsOffset + header.stringTableSize != a_data.size()) {
+			logger::error("Generation cache is truncated or corrupted. Ignoring it.");
+			return DecodeResult::kCorrupted;
+		}
+
+		View view;
+		view.data_ = a_data;
+		view.partCount_ = header.partCount;
+		view.extraCount_ = header.extraCount;
+		view.disabledCount_ = header.disabledCount;
+		view.partsOffset_ = partsOffset;
+		view.extrasOffset_ = extrasOffset;
+		view.disabledOffset_ = disabledOffset;
+		view.stringsOffset_ = stringsOffset;
+		view.stringTableSize_ = header.stringTableSize;
+
+		// Resolve the plugin table against the current load order; every FormRef depends on it
+		view.files_.reserve(header.pluginCount);
+		for (std::uint32_t i = 0; i < header.pluginCount; ++i) {
+			const auto offset = pluginsOffset + std::uint64_t{ i } * sizeof(PluginRecord);
+			PluginRecord record{};
+			record.nameOffset = in.Read<std::uint32_t>(offset);
+			record.nameLength = in.Read<std::uint16_t>(offset + 0x4);
+			record.fingerprint = in.Read<std::uint64_t>(offset + 0x8);
+
+			const auto fileName = view.ReadString(record.nameOffset, record.nameLength);
+			if (!fileName) {
+				logger::error("Generation cache plugin record {} is corrupted. Ignoring the cache.", i);
+				return DecodeResult::kCorrupted;
+			}
+
+			view.files_.push_back(a_findPlugin(*fileName));
+			if (record.fingerprint != 0) {
+				view.fingerprints_.push_back({ *fileName, record.fingerprint });
+			}
+		}
+
+		*this = std::move(view);
+		return DecodeResult::kOk;
+	}
+
+	std::optional<PlannedHeadPart> View::GetPart(std::uint32_t a_index) const
+	{
+		if (a_index >= partCount_) {
+			return std::nullopt;
+		}
+
+		const Reader in(data_);
+		const auto offset = partsOffset_ + std::uint64_t{ a_index } * sizeof(PartRecord);
+		const auto editorIDOffset = in.Read<std::uint32_t>(offset + 0x18);
+		const auto editorIDLength = in.Read<std::uint16_t>(offset + 0x1C);
+		const auto flags = in.Read<std::uint16_t>(offset + 0x1E);
+		const auto extraPartsBegin = in.Read<std::uint32_t>(offset + 0x20);
+		const auto extraPartsCount = in.Read<std::uint32_t>(offset + 0x24);
+
+		const auto editorID = ReadString(editorIDOffset, editorIDLength);
+		const auto sourceFormID = ReadFormRef(offset);
+		const auto formID = ReadFormRef(offset + 0x8);
+		const auto legacyFormID = ReadFormRef(offset + 0x10);
+		const std::uint64_t extraPartsEnd = std::uint64_t{ extraPartsBegin } + extraPartsCount;
+		if (!editorID || !sourceFormID || !formID || !legacyFormID || extraPartsEnd > extraCount_) {
+			logger::error("Generation cache record {} is corrupted. Ignoring the cache.", a_index);
+			return std::nullopt;
+		}
+
+		PlannedHeadPart planned;
+		planned.sourceFormID = *sourceFormID;
+		planned.formID = *formID;
+		planned.legacyFormID = *legacyFormID;
+		planned.editorID = *editorID;
+		planned.toFemale = (flags & kToFemale) != 0;
+		planned.extraPartsBegin = extraPartsBegin;
+		planned.extraPartsCount = extraPartsCount;
+		return planned;
+	}
+
+	std::optional<FormID> View::GetExtraPart(std::uint32_t a_index) const
+	{
+		if (a_index >= extraCount_) {
+			return std::nullopt;
+		}
+		return ReadFormRef(extrasOffset_ + std::uint64_t{ a_index } * sizeof(FormRef));
+	}
+
+	std::optional<FormID> View::GetDisabledPart(std::uint32_t a_index) const
+	{
+		if (a_index >= disabledCount_) {
+			return std::nullopt;
+		}
+		return ReadFormRef(disabledOffset_ + std::uint64_t{ a_index } * sizeof(FormRef));
+	}
+
+	std::optional<FormID> View::ReadFormRef(std::uint64_t a_offset) const
+	{
+		const auto ref = Reader(data_).ReadFormRef(a_offset);
+		if (ref.pluginIndex == NO_PLUGIN) {
+			return ref.localID;
+		}
+		if (ref.pluginIndex >= files_.size()) {
+			return std::nullopt;
+		}
+
+		const auto& file = files_[ref.pluginIndex];
+		if (!file) {
+			return FormID{ 0 };
+		}
+		return FormIDUtils::MakeFormID(file->compileIndex, file->isLight, ref.localID);
+	}
+
+	std::optional<std::string_view> View::ReadString(std::uint32_t a_offset, std::uint16_t a_length) const
+	{
+		const std::uint64_t end = std::uint64_t{ a_offset } + a_length;
+		const auto* strings = reinterpret_cast<const char*>(data_.data() + stringsOffset_);
+		if (end >= stringTableSize_ || strings[end] != '\0') {
+			return std::nullopt;
+		}
+		return std::string_view(strings + a_offset, a_length);
+	}
+
+	DecodeResult Decode(std::span<const std::byte> a_data, std::uint64_t a_key, const FindPlugin& a_findPlugin, GenerationPlan& a_outPlan)
+	{
+		View view;
+		if (const auto result = view.Open(a_data, a_key, a_findPlugin); result != DecodeResult::kOk) {
+			return result;
+		}
+
+		GenerationPlan plan;
+		plan.plugins.assign(view.GetPlugins().begin(), view.GetPlugins().end());
+
+		plan.headParts.reserve(view.GetPartCount());
+		for (std::uint32_t i = 0; i < view.GetPartCount(); ++i) {
+			const auto planned = view.GetPart(i);
+			if (!planned) {
+				return DecodeResult::kCorrupted;
+			}
+			plan.headParts.push_back(*planned);
+		}
+
+		const auto readAll = [](std::uint32_t a_count, const auto& a_read, std::vector<FormID>& a_out) {
+			a_out.reserve(a_count);
+			for (std::uint32_t i = 0; i < a_count; ++i) {
+				const auto formID = a_read(i);
+				if (!formID) {
+					return false;
+				}
+				a_out.push_back(*formID);
+			}
+			return true;
+		};
+		if (!readAll(view.GetExtraCount(), [&](std::uint32_t a_index) { return view.GetExtraPart(a_index); }, plan.extraParts) ||
+			!readAll(view.GetDisabledCount(), [&](std::uint32_t a_index) { return view.GetDisabledPart(a_index); }, plan.disabledParts)) {
+			logger::error("Generation cache references an unknown plugin. Ignoring the cache.");
+			return DecodeResult::kCorrupted;
+		}
+
+		a_outPlan = std::move(plan);
+		return DecodeResult::kOk;
+	}
+}
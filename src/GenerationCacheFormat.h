@@ -0,0 +1,91 @@
+#pragma once
+
+#include "GenerationPlan.h"
+
+// Byte-level reader and writer of the generation cache file
+// Knows nothing about the game; plugins are resolved through callbacks so the format can be tested on its own
+//
+// Records are read in place: View checks the header and section bounds when opened and each record when it is read,
+// so a caller only pays for the records it uses
+//
+// FormIDs are stored relative to the plugin table so the cache survives load order changes
+//
+// File layout (little-endian, versioned):
+//   Header
+//   PluginRecord[pluginCount]  plugins referenced by the file and their fingerprints
+//   PartRecord[partCount]      fixed-width head part records
+//   FormRef[extraCount]        extra part wiring referenced by the records
+//   FormRef[disabledCount]     originals hidden by ShowOnlyUnisexy
+//   char[stringTableSize]      NUL-terminated EditorIDs and plugin names referenced by the records
+namespace GenerationCacheFormat
+{
+	// Bump whenever the cache layout or the generation logic changes
+	inline constexpr std::uint32_t VERSION = 6;
+
+	inline constexpr std::size_t HEADER_SIZE = 0x28;
+
+	enum class DecodeResult
+	{
+		kOk,
+		kUnsupported,  // Wrong magic or version
+		kOutOfDate,    // Written for a different key
+		kCorrupted
+	};
+
+	// Name of the loaded plugin a FormID belongs to, or an empty view if it belongs to none
+	using GetPluginName = std::function<std::string_view(FormID a_formID)>;
+
+	// Where a plugin named in the cache sits in the current load order, or nullopt if it isn't loaded
+	// Only compileIndex and isLight of the result are used
+	using FindPlugin = std::function<std::optional<PluginInfo>(std::string_view a_fileName)>;
+
+	// Serialize the plan into a complete cache file
+	std::vector<std::byte> Encode(std::uint64_t a_key, const GenerationPlan& a_plan, const GetPluginName& a_getPluginName);
+
+	// Records of a cache file, read in place and resolved against the current load order as they are asked for
+	// References to plugins that are no longer loaded resolve to FormID 0
+	// EditorIDs and plugin names point into the data, which must outlive the view
+	class View
+	{
+	public:
+		// Check the header and that every section fits the data, and resolve the plugin table
+		// The view is only usable when kOk is returned
+		DecodeResult Open(std::span<const std::byte> a_data, std::uint64_t a_key, const FindPlugin& a_findPlugin);
+
+		// Plugins the plan was generated from, with their fingerprints
+		std::span<const PluginFingerprint> GetPlugins() const { return fingerprints_; }
+
+		std::uint32_t GetPartCount() const { return partCount_; }
+		std::uint32_t GetExtraCount() const { return extraCount_; }
+		std::uint32_t GetDisabledCount() const { return disabledCount_; }
+
+		// Read a head part record; nullopt if it is corrupted
+		// Its extra parts are read with GetExtraPart
+		std::optional<PlannedHeadPart> GetPart(std::uint32_t a_index) const;
+
+		// Read an entry of the extra part wiring or of the hidden originals; nullopt if it is corrupted
+		std::optional<FormID> GetExtraPart(std::uint32_t a_index) const;
+		std::optional<FormID> GetDisabledPart(std::uint32_t a_index) const;
+
+	private:
+		std::optional<FormID> ReadFormRef(std::uint64_t a_offset) const;
+		std::optional<std::string_view> ReadString(std::uint32_t a_offset, std::uint16_t a_length) const;
+
+		std::span<const std::byte> data_;
+		std::vector<std::optional<PluginInfo>> files_;  // Plugin table entries in the current load order
+		std::vector<PluginFingerprint> fingerprints_;
+		std::uint32_t partCount_ = 0;
+		std::uint32_t extraCount_ = 0;
+		std::uint32_t disabledCount_ = 0;
+		std::uint64_t partsOffset_ = 0;
+		std::uint64_t extrasOffset_ = 0;
+		std::uint64_t disabledOffset_ = 0;
+		std::uint64_t stringsOffset_ = 0;
+		std::uint32_t stringTableSize_ = 0;
+	};
+
+	// Read a whole cache file into a plan
+	// EditorIDs and plugin names in the returned plan point into a_data
+	// a_outPlan is only written when kOk is returned
+	DecodeResult Decode(std::span<const std::byte> a_data, std::uint64_t a_key, const FindPlugin& a_findPlugin, GenerationPlan& a_outPlan);
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "HeadPartSource.h"
+
+// A head part created by Unisexy, recorded so it can be recreated without regeneration
+struct PlannedHeadPart
+{
+	FormID sourceFormID = 0;            // Head part the new part is cloned from
+	FormID formID = 0;                  // FormID assigned to the new part
+	FormID legacyFormID = 0;            // FormID an older build assigned to the part, aliased in Migrate hash mode; 0 if none
+	std::string_view editorID;          // EditorID of the new part, always NUL-terminated
+	bool toFemale = false;              // Target gender of the new part
+	std::uint32_t extraPartsBegin = 0;  // First extra part in GenerationPlan::extraParts
+	std::uint32_t extraPartsCount = 0;  // Number of extra parts wired to the new part
+};
+
+// Fingerprint of the head parts a plugin provides
+// A plugin's generated parts can be reused as long as its fingerprint is unchanged
+struct PluginFingerprint
+{
+	std::string_view fileName;      // Plugin file name, always NUL-terminated
+	std::uint64_t fingerprint = 0;  // Hash of the plugin's winning head part records
+};
+
+// Everything a generation pass did to the head part list, in creation order
+// Laid out as flat arrays so it maps directly onto the cache file records
+struct GenerationPlan
+{
+	std::vector<PlannedHeadPart> headParts;  // Head parts created by Unisexy
+	std::vector<FormID> extraParts;          // Extra part wiring of all head parts, back to back
+	std::vector<FormID> disabledParts;       // Original head parts hidden by ShowOnlyUnisexy
+	std::vector<PluginFingerprint> plugins;  // Fingerprints of the plugins the plan was generated from
+
+	// Extra parts wired to a planned head part
+	std::span<const FormID> GetExtraParts(const PlannedHeadPart& a_part) const
+	{
+		return std::span(extraParts).subspan(a_part.extraPartsBegin, a_part.extraPartsCount);
+	}
+
+	// Append a head part and its extra part wiring
+	PlannedHeadPart& Add(
+		FormID a_sourceFormID,
+		FormID a_formID,
+		std::string_view a_editorID,
+		bool a_toFemale,
+		std::span<const FormID> a_extraParts)
+	{
+		auto& planned = headParts.emplace_back();
+		planned.sourceFormID = a_sourceFormID;
+		planned.formID = a_formID;
+		planned.editorID = a_editorID;
+		planned.toFemale = a_toFemale;
+		planned.extraPartsBegin = static_cast<std::uint32_t>(extraParts.size());
+		planned.extraPartsCount = static_cast<std::uint32_t>(a_extraParts.size());
+		extraParts.insert(extraParts.end(), a_extraParts.begin(), a_extraParts.end());
+		return planned;
+	}
+};
@@ -0,0 +1,254 @@
+#include "GenerationPlanner.h"
+#include "CorePCH.h"
+
+GenerationPlanner::GenerationPlanner(const IHeadPartSource& a_source, Options a_options) :
+	source_(a_source),
+	options_(std::move(a_options)),
+	formIDManager_(a_source, options_.hashMode, options_.verboseLogging),
+	resolver_(formIDManager_, editorIDIndex_, arena_, options_.verboseLogging, plan_, conflicts_)
+{
+	assert(options_.classifier && options_.rules);
+}
+
+GenerationPlanner::Candidate GenerationPlanner::Classify(const HeadPartRecord& a_headPart, const PluginVerdicts& a_pluginVerdicts) const
+{
+	Candidate candidate;
+	candidate.headPart = &a_headPart;
+	candidate.classification = options_.classifier->Classify(a_headPart.type, a_headPart.flags);
+
+	// The new head part's EditorID is derived from the source's
+	if (candidate.classification == Classification::kToFemale || candidate.classification == Classification::kToMale) {
+		if (a_headPart.editorID.empty()) {
+			candidate.classification = Classification::kNoEditorID;
+			return candidate;
+		}
+
+		// Rules match the plugin that defines the head part, not the last one to override it
+		if (!a_pluginVerdicts.empty()) {
+			const auto it = a_pluginVerdicts.find(a_headPart.originFile);
+			if (it != a_pluginVerdicts.end() && !it->second) {
+				candidate.classification = Classification::kExcludedByRule;
+				return candidate;
+			}
+		}
+		const auto& rules = *options_.rules;
+		if (rules.HasEditorIDRules() && !rules.IsEditorIDAllowed(a_headPart.editorID)) {
+			candidate.classification = Classification::kExcludedByRule;
+		}
+	}
+
+	return candidate;
+}
+
+void GenerationPlanner::Plan(PhaseTimer& a_phaseTimer, GenerationReport* a_report)
+{
+	using Phase = PhaseTimer::Phase;
+
+	const bool verboseLogging = options_.verboseLogging;
+	const auto headParts = source_.GetHeadParts();
+
+	// Build EditorID index of existing head parts to prevent duplicates and reuse created parts
+	{
+		const auto timer = a_phaseTimer.Measure(Phase::kIndexBuild);
+		editorIDIndex_.Build(source_);
+	}
+
+	// Classify every head part in parallel; this pass only reads the source and options
+	std::vector<Candidate> candidates;
+	{
+		const auto timer = a_phaseTimer.Measure(Phase::kClassify);
+
+		// Match plugin rules once per defining plugin instead of once per head part
+		PluginVerdicts pluginVerdicts;
+		const auto& rules = *options_.rules;
+		if (rules.HasPluginRules()) {
+			for (const auto& headPart : headParts) {
+				if (headPart.originFile && !pluginVerdicts.contains(headPart.originFile)) {
+					pluginVerdicts.emplace(headPart.originFile, rules.IsPluginAllowed(headPart.originFile->fileName));
+				}
+			}
+		}
+
+		candidates.resize(headParts.size());
+		std::transform(std::execution::par, headParts.begin(), headParts.end(), candidates.begin(),
+			[this, &pluginVerdicts](const HeadPartRecord& a_headPart) { return Classify(a_headPart, pluginVerdicts); });
+	}
+
+	// Index the FormIDs already taken in every plugin that will receive new forms, in one pass
+	{
+		const auto timer = a_phaseTimer.Measure(Phase::kFormIDScan);
+		std::vector<const PluginInfo*> targetFiles;
+		for (const auto& candidate : candidates) {
+			if (candidate.classification == Classification::kToFemale || candidate.classification == Classification::kToMale) {
+				const auto* file = candidate.headPart->file;
+				if (file && !options_.skippedFiles.contains(file) && std::ranges::find(targetFiles, file) == targetFiles.end()) {
+					targetFiles.push_back(file);
+				}
+			}
+		}
+		formIDManager_.SeedOccupancy(targetFiles);
+	}
+
+	// Plan every new head part serially in source order; FormIDs are reserved but nothing is created yet
+	std::vector<FormID> extraParts;
+	const auto flipLoopStart = std::chrono::steady_clock::now();
+	for (const auto& candidate : candidates) {
+		const auto* const headPart = candidate.headPart;
+
+		// Parts of unchanged plugins were restored from the generation cache, along with their flipped versions
+		// Parts generated by an earlier pass are never flipped again
+		if (options_.skippedFiles.contains(headPart->file) || options_.skippedSources.contains(headPart->formID)) {
+			continue;
+		}
+		stats_.processedCount++;
+
+		const auto headPartType = headPart->type;
+
+		switch (candidate.classification) {
+		case Classification::kNonPlayable:
+			if (verboseLogging && IsReportable(headPartType)) {
+				logger::info("Skipping non-playable head part: {} [{:08X}]",
+					headPart->editorID, headPart->formID);
+			}
+			continue;
+		case Classification::kGenderless:
+			if (options_.showOnlyUnisexy) {
+				plan_.disabledParts.push_back(headPart->formID);
+				stats_.disabledOriginalCount++;
+				if (verboseLogging) {
+					logger::info("Disabling genderless head part: {} [{:08X}] (Type: {})",
+						headPart->editorID, headPart->formID,
+						GetHeadPartTypeName(headPartType));
+				}
+			}
+			continue;
+		case Classification::kMaleDisabled:
+			// Track skipped parts for summary reporting
+			if (IsReportable(headPartType)) {
+				skippedByType_[headPartType].first++;
+			}
+			continue;
+		case Classification::kFemaleDisabled:
+			if (IsReportable(headPartType)) {
+				skippedByType_[headPartType].second++;
+			}
+			continue;
+		case Classification::kExcludedByRule:
+			if (verboseLogging) {
+				logger::info("Skipping head part excluded by rules: {} [{:08X}] from {}",
+					headPart->editorID, headPart->formID,
+					headPart->originFile ? headPart->originFile->fileName : "unknown plugin"sv);
+			}
+			continue;
+		case Classification::kNoEditorID:
+			stats_.otherWarningCount++;  // Increment for missing EditorID
+			continue;
+		case Classification::kToFemale:
+		case Classification::kToMale:
+			break;
+		default:
+			continue;
+		}
+
+		const bool toFemale = candidate.classification == Classification::kToFemale;
+
+		// Toggles an earlier pass generated parts for are already complete
+		if (options_.skippedToggles.test(GetToggleIndex(headPartType, toFemale))) {
+			continue;
+		}
+		const auto newEditorKey = MakeUnisexyEditorID(headPart->editorID, arena_);
+		const auto newEditorID = newEditorKey.str;
+
+		// Skip if we already created this head part
+		if (editorIDIndex_.Contains(newEditorKey)) {
+			if (verboseLogging) {
+				logger::info("Skipping duplicate head part: {}", newEditorID);
+			}
+			continue;
+		}
+
+		// Start of this part's work for the report, extra parts included
+		const auto partStart = std::chrono::steady_clock::now();
+		const auto plannedBefore = plan_.headParts.size();
+
+		// Get source file for FormID assignment
+		const PluginInfo* targetFile = headPart->file;
+		if (!targetFile) {
+			stats_.failedNoSourceFile++;
+			logger::error("No source file found for head part {} [{:08X}]. Skipping.",
+				headPart->editorID, headPart->formID);
+			continue;
+		}
+
+		// Reserve a FormID for the new head part
+		// Older builds assigned their FormID whether or not this one succeeds, so replay it either way
+		std::uint32_t conflictFormID = 0;
+		FormID newFormID = 0;
+		FormID legacyFormID = 0;
+		{
+			const auto timer = a_phaseTimer.Measure(Phase::kAssignFormID);
+			newFormID = formIDManager_.AssignFormID(newEditorKey, targetFile, conflictFormID);
+			legacyFormID = formIDManager_.AssignLegacyFormID(newEditorKey, targetFile);
+		}
+		if (!newFormID) {
+			stats_.formIDConflictCount++;                             // Increment for FormID conflict
+			conflicts_.emplace_back(newEditorID, conflictFormID, 0);  // Store conflict with no final FormID
+			logger::error("Failed to assign FormID for {}", newEditorID);
+			continue;
+		}
+
+		// Store conflict details if there was a conflict
+		if (conflictFormID != 0) {
+			conflicts_.emplace_back(newEditorID, conflictFormID, newFormID);
+			stats_.formIDConflictCount++;  // Increment for resolved conflict
+		}
+
+		// Plan extra parts; other types keep their source's extra parts as they are
+		extraParts.clear();
+		if (IsReportable(headPartType)) {
+			const auto timer = a_phaseTimer.Measure(Phase::kExtraParts);
+			resolver_.Resolve(headPart, toFemale, targetFile, extraParts);
+		} else {
+			for (const auto* extraPart : headPart->extraParts) {
+				if (extraPart) {
+					extraParts.push_back(extraPart->formID);
+				}
+			}
+		}
+
+		// Planned after its extra parts so they are created and registered first
+		plan_.Add(headPart->formID, newFormID, newEditorID, toFemale, extraParts).legacyFormID = legacyFormID;
+		editorIDIndex_.Insert(newEditorKey, newFormID);
+
+		if (a_report) {
+			const auto partDuration = std::chrono::steady_clock::now() - partStart;
+			for (auto i = plannedBefore; i < plan_.headParts.size(); ++i) {
+				const auto& planned = plan_.headParts[i];
+				const auto* source = source_.FindHeadPart(planned.sourceFormID);
+				const bool isExtraPart = i + 1 != plan_.headParts.size();
+				a_report->AddPart(planned, source ? source->type : HeadPartType::kMisc, isExtraPart,
+					isExtraPart ? std::chrono::nanoseconds::zero() : partDuration);
+			}
+		}
+
+		if (verboseLogging) {
+			logger::info("Planned head part: {} [{:08X}] (Type: {}) from source [{:08X}]",
+				newEditorID, newFormID,
+				GetHeadPartTypeName(headPartType),
+				headPart->formID);
+		}
+
+		// Disable original head part if configured to show only Unisexy versions
+		if (options_.showOnlyUnisexy) {
+			plan_.disabledParts.push_back(headPart->formID);
+			stats_.disabledOriginalCount++;
+			if (verboseLogging) {
+				logger::info("Disabling original head part: {} [{:08X}] (Type: {})",
+					headPart->editorID, headPart->formID,
+					GetHeadPartTypeName(headPartType));
+			}
+		}
+	}
+
+	a_phaseTimer.Add(Phase::kFlipLoop, std::chrono::steady_clock::now() - flipLoopStart);
+}
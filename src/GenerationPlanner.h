@@ -0,0 +1,110 @@
+#pragma once
+
+#include "EditorIDIndex.h"
+#include "ExtraPartResolver.h"
+#include "FormIDManager.h"
+#include "GenerationPlan.h"
+#include "GenerationReport.h"
+#include "HeadPartClassifier.h"
+#include "HeadPartRules.h"
+#include "HeadPartSource.h"
+#include "PhaseTimer.h"
+#include "StringArena.h"
+
+// One bit per head part type and target gender
+using HeadPartToggles = std::bitset<std::to_underlying(HeadPartType::kTotal) * 2>;
+
+// Index of a type and gender toggle in HeadPartToggles
+constexpr std::size_t GetToggleIndex(HeadPartType a_type, bool a_toFemale)
+{
+	return std::to_underlying(a_type) * 2 + (a_toFemale ? 1 : 0);
+}
+
+// Plans the head parts a generation pass creates from the head parts of a source
+// Classifies every part, reserves FormIDs and resolves extra parts; nothing is created
+class GenerationPlanner
+{
+public:
+	using Classification = HeadPartClassifier::Classification;
+
+	// EditorID, conflicting FormID, final FormID (0 if none was assigned)
+	using Conflict = std::tuple<std::string_view, std::uint32_t, std::uint32_t>;
+
+	// Male skips, female skips per head part type
+	using SkippedByType = std::map<HeadPartType, std::pair<int, int>>;
+
+	// Only log skips and flip extra parts for these major types to avoid spam
+	static constexpr std::array REPORTABLE_TYPES = {
+		HeadPartType::kHair,
+		HeadPartType::kFacialHair,
+		HeadPartType::kScar,
+		HeadPartType::kEyebrows,
+	};
+
+	struct Options
+	{
+		const HeadPartClassifier* classifier = nullptr;
+		const HeadPartRules* rules = nullptr;
+		FormIDUtils::HashMode hashMode = FormIDUtils::HashMode::kLegacy;
+		bool showOnlyUnisexy = false;
+		bool verboseLogging = false;
+		std::unordered_set<const PluginInfo*> skippedFiles;  // Plugins whose parts were restored from the cache
+		std::unordered_set<FormID> skippedSources;           // Parts generated by an earlier pass, never flipped again
+		HeadPartToggles skippedToggles;                      // Toggles an earlier pass generated parts for
+	};
+
+	struct Stats
+	{
+		int processedCount = 0;
+		int failedNoSourceFile = 0;
+		int disabledOriginalCount = 0;
+		int formIDConflictCount = 0;
+		int otherWarningCount = 0;
+	};
+
+	GenerationPlanner(const IHeadPartSource& a_source, Options a_options);
+
+	// Plan every new head part serially in source order, timing each phase
+	// Records every planned part in a_report if given
+	void Plan(PhaseTimer& a_phaseTimer, GenerationReport* a_report = nullptr);
+
+	const GenerationPlan& GetPlan() const { return plan_; }
+	const std::vector<Conflict>& GetConflicts() const { return conflicts_; }
+	const Stats& GetStats() const { return stats_; }
+	const SkippedByType& GetSkippedByType() const { return skippedByType_; }
+	const StringArena& GetArena() const { return arena_; }
+	const ExtraPartResolver& GetResolver() const { return resolver_; }
+
+private:
+	// Precomputed classification of a head part, consumed by the serial planning loop
+	struct Candidate
+	{
+		const HeadPartRecord* headPart = nullptr;
+		Classification classification = Classification::kNone;
+	};
+
+	// Plugin rule verdicts, decided once per plugin before the parallel pass
+	using PluginVerdicts = std::unordered_map<const PluginInfo*, bool>;
+
+	// Classify a head part
+	// Only reads the source, options and plugin verdicts so it can run on any thread
+	Candidate Classify(const HeadPartRecord& a_headPart, const PluginVerdicts& a_pluginVerdicts) const;
+
+	static bool IsReportable(HeadPartType a_type)
+	{
+		return std::ranges::find(REPORTABLE_TYPES, a_type) != REPORTABLE_TYPES.end();
+	}
+
+	const IHeadPartSource& source_;
+	Options options_;
+
+	// Generated EditorIDs live in the arena for the whole pass; the index, plan and conflicts view into it
+	StringArena arena_;
+	EditorIDIndex editorIDIndex_;
+	FormIDManager formIDManager_;
+	GenerationPlan plan_;
+	std::vector<Conflict> conflicts_;
+	ExtraPartResolver resolver_;
+	Stats stats_;
+	SkippedByType skippedByType_;
+};
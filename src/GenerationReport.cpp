@@ -0,0 +1,104 @@
+#include "GenerationReport.h"
+#include "CorePCH.h"
+
+namespace
+{
+	// Append a JSON string literal, escaping quotes, backslashes and control characters
+	void AppendJSONString(fmt::memory_buffer& a_buffer, std::string_view a_str)
+	{
+		a_buffer.push_back('"');
+		for (const char c : a_str) {
+			switch (c) {
+			case '"':
+				a_buffer.append("\\\""sv);
+				break;
+			case '\\':
+				a_buffer.append("\\\\"sv);
+				break;
+			default:
+				if (static_cast<unsigned char>(c) < 0x20) {
+					fmt::format_to(std::back_inserter(a_buffer), "\\u{:04x}", static_cast<unsigned char>(c));
+				} else {
+					a_buffer.push_back(c);
+				}
+				break;
+			}
+		}
+		a_buffer.push_back('"');
+	}
+}
+
+void GenerationReport::AddPart(const PlannedHeadPart& a_part, HeadPartType a_type, bool a_isExtraPart, std::chrono::nanoseconds a_duration)
+{
+	auto& record = parts_.emplace_back();
+	record.sourceFormID = a_part.sourceFormID;
+	record.formID = a_part.formID;
+	record.editorID = a_part.editorID;
+	record.type = a_type;
+	record.toFemale = a_part.toFemale;
+	record.isExtraPart = a_isExtraPart;
+	record.duration = a_duration;
+}
+
+bool GenerationReport::Write(
+	const std::filesystem::path& a_path,
+	std::span<const std::tuple<std::string_view, std::uint32_t, std::uint32_t>> a_conflicts,
+	const Summary& a_summary) const
+{
+	// Hashed FormID each part wanted before it was moved, keyed by the FormID it got
+	std::unordered_map<FormID, FormID> conflictsByFormID;
+	conflictsByFormID.reserve(a_conflicts.size());
+	for (const auto& [editorID, conflictFormID, finalFormID] : a_conflicts) {
+		if (finalFormID != 0) {
+			conflictsByFormID.emplace(finalFormID, conflictFormID);
+		}
+	}
+
+	fmt::memory_buffer buffer;
+	auto out = std::back_inserter(buffer);
+
+	for (const auto& record : parts_) {
+		buffer.append(R"({"record":"part","editorID":)"sv);
+		AppendJSONString(buffer, record.editorID);
+		fmt::format_to(out, R"(,"source":"{:08X}","formID":"{:08X}","type":"{}","direction":"{}","extra":{},)",
+			record.sourceFormID, record.formID, GetHeadPartTypeName(record.type),
+			record.toFemale ? "toFemale" : "toMale", record.isExtraPart);
+		if (const auto it = conflictsByFormID.find(record.formID); it != conflictsByFormID.end()) {
+			fmt::format_to(out, R"("conflict":"{:08X}",)", it->second);
+		} else {
+			buffer.append(R"("conflict":null,)"sv);
+		}
+		fmt::format_to(out, R"("durationUs":{:.1f}}})" "\n",
+			std::chrono::duration<double, std::micro>(record.duration).count());
+	}
+
+	for (const auto& [editorID, conflictFormID, finalFormID] : a_conflicts) {
+		if (finalFormID == 0) {
+			buffer.append(R"({"record":"failure","editorID":)"sv);
+			AppendJSONString(buffer, editorID);
+			fmt::format_to(out, R"(,"conflict":"{:08X}"}})" "\n", conflictFormID);
+		}
+	}
+
+	fmt::format_to(out, R"({{"record":"summary","processed":{},"created":{},"restored":{},"disabled":{},"formIDConflicts":{},"warnings":{},"seconds":{:.3f},"skipped":{{)",
+		a_summary.processedCount, a_summary.createdCount, a_summary.restoredCount, a_summary.disabledCount,
+		a_summary.formIDConflictCount, a_summary.otherWarningCount, a_summary.seconds);
+	if (a_summary.skippedByType) {
+		bool first = true;
+		for (const auto& [type, skipped] : *a_summary.skippedByType) {
+			fmt::format_to(out, R"({}"{}":{{"male":{},"female":{}}})",
+				first ? "" : ",", GetHeadPartTypeName(type), skipped.first, skipped.second);
+			first = false;
+		}
+	}
+	buffer.append("}}\n"sv);
+
+	std::ofstream file(a_path, std::ios::binary | std::ios::trunc);
+	if (!file || !file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()))) {
+		logger::error("Failed to write generation report '{}'. Check file permissions.", a_path.string());
+		return false;
+	}
+
+	logger::info("Wrote generation report with {} head parts to {}", parts_.size(), a_path.string());
+	return true;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "GenerationPlan.h"
+#include "HeadPartSource.h"
+
+// Machine-readable record of a generation pass, written as JSON Lines
+// One "part" record per planned head part, one "failure" record per part that
+// could not get a FormID, and a final "summary" record
+// Parts restored from the generation cache are only counted in the summary
+class GenerationReport
+{
+public:
+	// Run-wide counters for the summary record
+	struct Summary
+	{
+		std::size_t processedCount = 0;
+		std::size_t createdCount = 0;
+		std::size_t restoredCount = 0;  // Created parts restored from the generation cache
+		std::size_t disabledCount = 0;
+		std::size_t formIDConflictCount = 0;
+		std::size_t otherWarningCount = 0;
+		double seconds = 0.0;
+		const std::map<HeadPartType, std::pair<int, int>>* skippedByType = nullptr;  // male skips, female skips
+	};
+
+	// Record a head part planned for creation from a source part of the given type
+	// a_duration is the time spent planning it, including the extra parts planned for it
+	void AddPart(const PlannedHeadPart& a_part, HeadPartType a_type, bool a_isExtraPart, std::chrono::nanoseconds a_duration);
+
+	// Write every record to the report file in one buffered pass
+	// a_conflicts holds (EditorID, conflicting FormID, final FormID) as collected during generation
+	bool Write(
+		const std::filesystem::path& a_path,
+		std::span<const std::tuple<std::string_view, std::uint32_t, std::uint32_t>> a_conflicts,
+		const Summary& a_summary) const;
+
+private:
+	struct PartRecord
+	{
+		FormID sourceFormID = 0;
+		FormID formID = 0;
+		std::string_view editorID;  // Owned by the generation pass
+		HeadPartType type = HeadPartType::kMisc;
+		bool toFemale = false;
+		bool isExtraPart = false;
+		std::chrono::nanoseconds duration{};
+	};
+
+	std::vector<PartRecord> parts_;
+};
@@ -0,0 +1,117 @@
+#pragma once
+
+// Case-insensitive matcher for a set of glob patterns ('*' matches any run of characters, '?' any one)
+// Patterns are indexed by their literal prefix in a trie, so a lookup walks the input once
+// and only tests the wildcard tails of patterns whose prefix matched
+class GlobMatcher
+{
+public:
+	GlobMatcher() :
+		nodes_(1)
+	{}
+
+	// Add a pattern
+	void Add(std::string_view a_pattern)
+	{
+		std::string pattern(a_pattern);
+		for (auto& c : pattern) {
+			c = ToLower(c);
+		}
+
+		const auto prefixLength = (std::min)(pattern.find_first_of("*?"), pattern.size());
+		std::uint32_t node = 0;
+		for (std::size_t i = 0; i < prefixLength; ++i) {
+			node = GetOrAddChild(node, pattern[i]);
+		}
+		nodes_[node].tails.push_back(pattern.substr(prefixLength));
+		patternCount_++;
+	}
+
+	// Check if any pattern matches the whole string
+	bool Matches(std::string_view a_str) const
+	{
+		std::uint32_t node = 0;
+		for (std::size_t i = 0;; ++i) {
+			for (const auto& tail : nodes_[node].tails) {
+				if (MatchTail(tail, a_str.substr(i))) {
+					return true;
+				}
+			}
+			if (i == a_str.size()) {
+				return false;
+			}
+
+			const auto child = FindChild(node, ToLower(a_str[i]));
+			if (!child) {
+				return false;
+			}
+			node = *child;
+		}
+	}
+
+	bool IsEmpty() const { return patternCount_ == 0; }
+
+private:
+	struct Node
+	{
+		std::vector<std::pair<char, std::uint32_t>> children;
+		std::vector<std::string> tails;  // Remainders of the patterns whose literal prefix ends here
+	};
+
+	static char ToLower(char a_c)
+	{
+		return static_cast<char>(std::tolower(static_cast<unsigned char>(a_c)));
+	}
+
+	std::optional<std::uint32_t> FindChild(std::uint32_t a_node, char a_c) const
+	{
+		for (const auto& [c, child] : nodes_[a_node].children) {
+			if (c == a_c) {
+				return child;
+			}
+		}
+		return std::nullopt;
+	}
+
+	std::uint32_t GetOrAddChild(std::uint32_t a_node, char a_c)
+	{
+		if (const auto child = FindChild(a_node, a_c)) {
+			return *child;
+		}
+		const auto child = static_cast<std::uint32_t>(nodes_.size());
+		nodes_.emplace_back();
+		nodes_[a_node].children.emplace_back(a_c, child);
+		return child;
+	}
+
+	// Match a lowercase pattern tail against the rest of the input
+	// Greedy with a single backtrack point, so it runs in O(tail * input) at worst
+	static bool MatchTail(std::string_view a_tail, std::string_view a_str)
+	{
+		std::size_t p = 0;
+		std::size_t s = 0;
+		std::size_t starP = std::string_view::npos;
+		std::size_t starS = 0;
+		while (s < a_str.size()) {
+			if (p < a_tail.size() && (a_tail[p] == '?' || a_tail[p] == ToLower(a_str[s]))) {
+				++p;
+				++s;
+			} else if (p < a_tail.size() && a_tail[p] == '*') {
+				starP = p++;
+				starS = s;
+			} else if (starP != std::string_view::npos) {
+				p = starP + 1;
+				s = ++starS;
+			} else {
+				return false;
+			}
+		}
+		while (p < a_tail.size() && a_tail[p] == '*') {
+			++p;
+		}
+		return p == a_tail.size();
+	}
+
+	std::vector<Node> nodes_;  // nodes_[0] is the root
+	std::size_t patternCount_ = 0;
+};
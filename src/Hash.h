@@ -0,0 +1,84 @@
+#pragma once
+
+// Stable 64-bit FNV-1a hashing
+// Unlike std::hash the results are identical across compilers, runtimes and builds
+namespace Hash
+{
+	inline constexpr std::uint64_t FNV_OFFSET_BASIS = 0xCBF29CE484222325;
+	inline constexpr std::uint64_t FNV_PRIME = 0x100000001B3;
+
+	// Hash a string, optionally continuing from a previous hash
+	constexpr std::uint64_t FNV1a(std::string_view a_str, std::uint64_t a_hash = FNV_OFFSET_BASIS)
+	{
+		for (const char c : a_str) {
+			a_hash ^= static_cast<std::uint8_t>(c);
+			a_hash *= FNV_PRIME;
+		}
+		return a_hash;
+	}
+
+	// Incremental hasher for composite keys
+	class Hasher
+	{
+	public:
+		// Mix in a string, length-prefixed so adjacent strings can't alias
+		constexpr void Update(std::string_view a_str)
+		{
+			Update(static_cast<std::uint64_t>(a_str.size()));
+			hash_ = FNV1a(a_str, hash_);
+		}
+
+		// Mix in an integral or enum value byte by byte in little-endian order
+		template <class T>
+			requires std::is_integral_v<T> || std::is_enum_v<T>
+		constexpr void Update(T a_value)
+		{
+			auto value = static_cast<std::uint64_t>(a_value);
+			for (std::size_t i = 0; i < sizeof(T); ++i) {
+				hash_ ^= static_cast<std::uint8_t>(value & 0xFF);
+				hash_ *= FNV_PRIME;
+				value >>= 8;
+			}
+		}
+
+		constexpr std::uint64_t Get() const { return hash_; }
+
+	private:
+		std::uint64_t hash_ = FNV_OFFSET_BASIS;
+	};
+
+	// A string with its FNV-1a hash computed once, for keys that are hashed and compared repeatedly
+	// Only views the string, which must outlive the key
+	struct HashedKey
+	{
+		constexpr HashedKey() = default;
+		constexpr explicit HashedKey(std::string_view a_str) :
+			str(a_str),
+			hash(FNV1a(a_str))
+		{}
+
+		// The hashes reject almost every mismatch before the strings are compared
+		constexpr bool operator==(const HashedKey& a_rhs) const
+		{
+			return hash == a_rhs.hash && str == a_rhs.str;
+		}
+
+		std::string_view str;
+		std::uint64_t hash = FNV_OFFSET_BASIS;
+	};
+
+	// Hash functor for unordered containers keyed by HashedKey
+	struct HashedKeyHash
+	{
+		std::size_t operator()(const HashedKey& a_key) const noexcept
+		{
+			return static_cast<std::size_t>(a_key.hash);
+		}
+	};
+
+	// Reference values from the FNV specification
+	static_assert(FNV1a("") == 0xCBF29CE484222325);
+	static_assert(FNV1a("a") == 0xAF63DC4C8601EC8C);
+	static_assert(FNV1a("foobar") == 0x85944171F73967E8);
+	static_assert(HashedKey("foobar").hash == FNV1a("foobar") && HashedKey() == HashedKey(""));
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "HeadPartSource.h"
+
+// Decides how a generation pass handles a head part from its type and flags with a single table lookup
+class HeadPartClassifier
+{
+public:
+	// How the generation pass handles a head part
+	enum class Classification : std::uint8_t
+	{
+		kNone,            // Null entry in the form array
+		kNonPlayable,     // Not selectable by the player
+		kMisc,            // kMisc parts are never flipped
+		kGenderless,      // Usable by both genders already
+		kMaleDisabled,    // Female part, but female -> male conversion is disabled
+		kFemaleDisabled,  // Male part, but male -> female conversion is disabled
+		kBothGenders,     // Flagged as both male and female
+		kNoEditorID,      // Would be flipped, but has no EditorID to derive from
+		kExcludedByRule,  // Would be flipped, but a [Rules] entry excludes its plugin or EditorID
+		kToFemale,        // Flip male part to female
+		kToMale,          // Flip female part to male
+	};
+
+	static constexpr std::size_t TYPE_COUNT = std::to_underlying(HeadPartType::kTotal);
+
+	// Gender conversions enabled for one head part type
+	struct TypeToggles
+	{
+		bool maleEnabled = false;    // Enable male conversion (female -> male)
+		bool femaleEnabled = false;  // Enable female conversion (male -> female)
+	};
+
+	// Precompute Classify for every type and flag combination
+	void Build(std::span<const TypeToggles, TYPE_COUNT> a_toggles)
+	{
+		for (std::size_t index = 0; index < TABLE_SIZE; ++index) {
+			const std::size_t type = index >> 3;
+			const bool isPlayable = (index & 1) != 0;
+			const bool isMale = (index & 2) != 0;
+			const bool isFemale = (index & 4) != 0;
+			const TypeToggles toggles = type < TYPE_COUNT ? a_toggles[type] : TypeToggles{};
+
+			auto& classification = table_[index];
+			if (!isPlayable) {
+				classification = Classification::kNonPlayable;
+			} else if (type == std::to_underlying(HeadPartType::kMisc)) {
+				classification = Classification::kMisc;
+			} else if (!isMale && !isFemale) {
+				classification = Classification::kGenderless;
+			} else if (isMale && isFemale) {
+				classification = Classification::kBothGenders;
+			} else if (isMale) {
+				classification = toggles.femaleEnabled ? Classification::kToFemale : Classification::kFemaleDisabled;
+			} else {
+				classification = toggles.maleEnabled ? Classification::kToMale : Classification::kMaleDisabled;
+			}
+		}
+	}
+
+	// Returns the flip direction or the reason the part is skipped; never kNone, kNoEditorID or kExcludedByRule
+	Classification Classify(HeadPartType a_type, std::uint8_t a_flags) const
+	{
+		const std::size_t type = (std::min)(static_cast<std::size_t>(std::to_underlying(a_type)), TYPE_COUNT);
+		const std::size_t index = (type << 3) |
+		                          ((a_flags & std::to_underlying(HeadPartFlag::kPlayable)) ? 1 : 0) |
+		                          ((a_flags & std::to_underlying(HeadPartFlag::kMale)) ? 2 : 0) |
+		                          ((a_flags & std::to_underlying(HeadPartFlag::kFemale)) ? 4 : 0);
+		return table_[index];
+	}
+
+private:
+	// Table index: type in the high bits, playable/male/female flags in the low three
+	// The extra type row catches out-of-range types, which are never enabled
+	static constexpr std::size_t TABLE_SIZE = (TYPE_COUNT + 1) << 3;
+
+	std::array<Classification, TABLE_SIZE> table_{};
+};
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "GlobMatcher.h"
+#include "Hash.h"
+
+// Include and exclude rules from the [Rules] INI section
+// A plugin or EditorID passes if it matches an include pattern, or there are none,
+// and matches no exclude pattern
+class HeadPartRules
+{
+public:
+	enum class Kind : std::uint32_t
+	{
+		kIncludePlugin,
+		kExcludePlugin,
+		kIncludeEditorID,
+		kExcludeEditorID,
+
+		kTotal
+	};
+
+	// INI key names, indexed by Kind
+	static constexpr std::array<std::string_view, std::to_underlying(Kind::kTotal)> KEY_NAMES = {
+		"IncludePlugin"sv, "ExcludePlugin"sv, "IncludeEditorID"sv, "ExcludeEditorID"sv
+	};
+
+	// Add a pattern; empty patterns are ignored
+	void Add(Kind a_kind, std::string_view a_pattern)
+	{
+		if (a_pattern.empty()) {
+			return;
+		}
+		const auto index = std::to_underlying(a_kind);
+		patterns_[index].emplace_back(a_pattern);
+		matchers_[index].Add(a_pattern);
+	}
+
+	// Patterns of one kind, in the order they were added
+	std::span<const std::string> GetPatterns(Kind a_kind) const { return patterns_[std::to_underlying(a_kind)]; }
+
+	bool HasPluginRules() const { return !IsEmpty(Kind::kIncludePlugin) || !IsEmpty(Kind::kExcludePlugin); }
+	bool HasEditorIDRules() const { return !IsEmpty(Kind::kIncludeEditorID) || !IsEmpty(Kind::kExcludeEditorID); }
+
+	// Check if head parts from a plugin may be flipped
+	bool IsPluginAllowed(std::string_view a_fileName) const
+	{
+		return IsAllowed(Kind::kIncludePlugin, Kind::kExcludePlugin, a_fileName);
+	}
+
+	// Check if a head part with this EditorID may be flipped
+	bool IsEditorIDAllowed(std::string_view a_editorID) const
+	{
+		return IsAllowed(Kind::kIncludeEditorID, Kind::kExcludeEditorID, a_editorID);
+	}
+
+	// Mix every pattern into a settings hash
+	void AddToHash(Hash::Hasher& a_hasher) const
+	{
+		for (const auto& patterns : patterns_) {
+			a_hasher.Update(static_cast<std::uint64_t>(patterns.size()));
+			for (const auto& pattern : patterns) {
+				a_hasher.Update(std::string_view(pattern));
+			}
+		}
+	}
+
+	bool operator==(const HeadPartRules& a_rhs) const { return patterns_ == a_rhs.patterns_; }
+
+private:
+	bool IsEmpty(Kind a_kind) const { return matchers_[std::to_underlying(a_kind)].IsEmpty(); }
+
+	bool IsAllowed(Kind a_include, Kind a_exclude, std::string_view a_str) const
+	{
+		const auto& include = matchers_[std::to_underlying(a_include)];
+		const auto& exclude = matchers_[std::to_underlying(a_exclude)];
+		return (include.IsEmpty() || include.Matches(a_str)) && (exclude.IsEmpty() || !exclude.Matches(a_str));
+	}
+
+	std::array<std::vector<std::string>, std::to_underlying(Kind::kTotal)> patterns_;
+	std::array<GlobMatcher, std::to_underlying(Kind::kTotal)> matchers_;
+};
@@ -0,0 +1,91 @@
+#pragma once
+
+// Engine-free view of the head parts a generation pass reads
+// The plugin snapshots the data handler into it; tests and benchmarks fill one in memory
+
+using FormID = std::uint32_t;
+
+// Head part types, numbered like RE::BGSHeadPart::HeadPartType
+enum class HeadPartType : std::uint32_t
+{
+	kMisc,
+	kFace,
+	kEyes,
+	kHair,
+	kFacialHair,
+	kScar,
+	kEyebrows,
+
+	kTotal
+};
+
+// Head part flag bits, valued like RE::BGSHeadPart::Flag
+enum class HeadPartFlag : std::uint8_t
+{
+	kPlayable = 1 << 0,
+	kMale = 1 << 1,
+	kFemale = 1 << 2,
+};
+
+// Get human-readable name for head part type
+constexpr std::string_view GetHeadPartTypeName(HeadPartType a_type)
+{
+	switch (a_type) {
+	case HeadPartType::kHair:
+		return "Hair";
+	case HeadPartType::kFacialHair:
+		return "FacialHair";
+	case HeadPartType::kScar:
+		return "Scars";
+	case HeadPartType::kEyebrows:
+		return "Brows";
+	case HeadPartType::kMisc:
+		return "Misc";
+	default:
+		return "Unknown";
+	}
+}
+
+// A loaded plugin that head parts come from or new head parts go to
+struct PluginInfo
+{
+	std::string_view fileName;       // Always NUL-terminated
+	std::uint32_t compileIndex = 0;  // Light compile index for light plugins
+	bool isLight = false;
+};
+
+// A head part record as the generation pass sees it
+struct HeadPartRecord
+{
+	FormID formID = 0;
+	std::string_view editorID;                          // Empty if the record has none
+	HeadPartType type = HeadPartType::kMisc;
+	std::uint8_t flags = 0;                             // HeadPartFlag bits
+	const PluginInfo* file = nullptr;                   // Plugin providing the winning record; flipped versions go there
+	const PluginInfo* originFile = nullptr;             // Plugin defining the record, which plugin rules match
+	std::span<const HeadPartRecord* const> extraParts;  // May hold null entries
+
+	bool HasFlag(HeadPartFlag a_flag) const { return (flags & std::to_underlying(a_flag)) != 0; }
+};
+
+// Where a generation pass reads head parts and FormID occupancy from
+class IHeadPartSource
+{
+public:
+	virtual ~IHeadPartSource() = default;
+
+	// Every head part, in form array order
+	virtual std::span<const HeadPartRecord> GetHeadParts() const = 0;
+
+	// Find a head part by FormID, including extra parts missing from the form array
+	virtual const HeadPartRecord* FindHeadPart(FormID a_formID) const = 0;
+
+	// Call a_visitor with the FormID of every loaded form, head parts included
+	virtual void ForEachFormID(const std::function<void(FormID)>& a_visitor) const = 0;
+
+	// Whether any form is loaded with the FormID, head parts included
+	virtual bool HasForm(FormID a_formID) const = 0;
+
+	// EditorID of any loaded form, or an empty string if it has none; only used for logging
+	virtual std::string_view GetEditorID(FormID a_formID) const = 0;
+};
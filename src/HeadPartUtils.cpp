@@ -1,35 +1,29 @@
 #include "HeadPartUtils.h"
 #include "PCH.h"
+#include "RaceRemapper.h"
 
 namespace HeadPartUtils
 {
-	std::string GenerateUnisexyEditorID(const RE::BGSHeadPart* a_headPart)
+	const RE::TESFile* GetFileFromFormID(RE::FormID a_formID)
 	{
-		// Source head part should never be null from loaded game data
-		assert(a_headPart);
-
-		const char* editorID = a_headPart->GetFormEditorID();
-		// Some forms legitimately have no EditorID - this check is still needed
-		if (!editorID || editorID[0] == '\0') {
-			if (Settings::GetSingleton()->IsVerboseLogging()) {
-				logger::debug("Head part [{:08X}] has no EditorID - skipping", a_headPart->GetFormID());
-			}
-			return "";
+		auto& dataHandler = *RE::TESDataHandler::GetSingleton();
+		if (FormIDUtils::IsLightFormID(a_formID)) {
+			// Resolve ESL plugin from FormID
+			const auto smallIndex = static_cast<std::uint16_t>(FormIDUtils::GetFileIndex(a_formID));
+			return dataHandler.LookupLoadedLightModByIndex(smallIndex);
+		} else {
+			// Resolve ESP/ESM plugin from FormID
+			const auto index = static_cast<std::uint8_t>(FormIDUtils::GetFileIndex(a_formID));
+			return dataHandler.LookupLoadedModByIndex(index);
 		}
-
-		// Reserve space to avoid reallocation
-		std::string result;
-		result.reserve(strlen(editorID) + 8);  // "_Unisexy" is 8 chars
-		result = editorID;
-		result += "_Unisexy";
-		return result;
 	}
 
 	RE::BGSHeadPart* CreateUnisexyHeadPart(
 		RE::IFormFactory* a_factory,
 		const RE::BGSHeadPart* a_sourcePart,
-		const std::string& a_newEditorID,
+		std::string_view a_newEditorID,
 		bool a_toFemale,
+		const RE::TESFile* a_targetFile,
 		[[maybe_unused]] const Settings& a_settings)
 	{
 		// Factory and source should never be null from validated game data
@@ -43,7 +37,7 @@ namespace HeadPartUtils
 		}
 
 		// Set the new EditorID
-		newHeadPart->SetFormEditorID(a_newEditorID.c_str());
+		newHeadPart->SetFormEditorID(a_newEditorID.data());
 
 		// Copy all properties from source
 		newHeadPart->flags = a_sourcePart->flags;
@@ -51,7 +45,7 @@ namespace HeadPartUtils
 		newHeadPart->extraParts = a_sourcePart->extraParts;
 		newHeadPart->textureSet = a_sourcePart->textureSet;
 		newHeadPart->color = a_sourcePart->color;
-		newHeadPart->validRaces = a_sourcePart->validRaces;
+		newHeadPart->validRaces = RaceRemapper::GetSingleton()->GetValidRaces(a_sourcePart->validRaces, a_toFemale, a_targetFile);
 		newHeadPart->model = a_sourcePart->model;
 
 		// Copy morph data - use memcpy for better performance
@@ -74,195 +68,278 @@ namespace HeadPartUtils
 		return newHeadPart;
 	}
 
-	bool ProcessExtraParts(
-		RE::BGSHeadPart* a_newHeadPart,
-		const RE::BGSHeadPart* a_sourcePart,
-		FormIDManager& a_formIDManager,
-		const RE::TESFile* a_targetFile,
-		std::set<std::string>& a_existingEditorIDs,
-		const Settings& a_settings,
-		int& a_createdCount,
-		std::vector<std::tuple<std::string, std::uint32_t, std::uint32_t>>& a_conflictDetails)
+	void RegisterHeadParts(std::span<RE::BGSHeadPart* const> a_headParts)
 	{
-		// All parameters should be valid from caller
-		assert(a_newHeadPart && a_sourcePart && a_targetFile);
-
-		// Early exit if no extra parts to process
-		const auto& extraParts = a_sourcePart->extraParts;
-		if (extraParts.empty()) {
-			if (a_settings.IsVerboseLogging()) {
-				logger::debug("No extra parts to process for head part {} [{:08X}]",
-					a_newHeadPart->GetFormEditorID() ? a_newHeadPart->GetFormEditorID() : "NoEditorID",
-					a_newHeadPart->formID);
-			}
-			return true;
-		}
+		auto& dataHandler = *RE::TESDataHandler::GetSingleton();
 
-		// Get factory for creating extra parts
-		const auto headFactory = RE::IFormFactory::GetConcreteFormFactoryByType<RE::BGSHeadPart>();
-		assert(headFactory);
+		// Grow the head part array once instead of once per form
+		auto& formArray = dataHandler.GetFormArray<RE::BGSHeadPart>();
+		formArray.reserve(static_cast<std::uint32_t>(formArray.size() + a_headParts.size()));
 
-		// Determine target gender from new head part's flags (cache the result)
-		const bool targetIsFemale = a_newHeadPart->flags.all(RE::BGSHeadPart::Flag::kFemale);
+		// The engine keeps its own bookkeeping and locking for each form it is handed, which isn't safe to bypass
+		for (auto* headPart : a_headParts) {
+			dataHandler.AddFormToDataHandler(headPart);
+		}
+	}
 
-		// Pre-allocate result array to avoid reallocations
-		RE::BSTArray<RE::BGSHeadPart*> newExtraParts;
-		newExtraParts.reserve(extraParts.size());
+	std::size_t RegisterLegacyFormIDAliases(std::span<const CreatedHeadPart> a_createdParts)
+	{
+		const bool verboseLogging = Settings::GetSingleton()->IsVerboseLogging();
+		std::size_t aliasCount = 0;
 
-		// Cache verbose logging setting
-		const bool verboseLogging = a_settings.IsVerboseLogging();
+		auto [allForms, lock] = RE::TESForm::GetAllForms();
+		RE::BSWriteLockGuard locker{ lock };
 
-		// Cache data handler reference
-		auto& dataHandler = *RE::TESDataHandler::GetSingleton();
+		for (const auto& createdPart : a_createdParts) {
+			auto* headPart = createdPart.headPart;
+			const auto legacyFormID = createdPart.legacyFormID;
+			if (!headPart || legacyFormID == 0 || legacyFormID == headPart->formID) {
+				continue;
+			}
 
-		// Process each extra part
-		if (verboseLogging) {
-			logger::info("Processing {} extra parts for head part {} [{:08X}] -> {} [{:08X}]",
-				extraParts.size(),
-				a_sourcePart->GetFormEditorID() ? a_sourcePart->GetFormEditorID() : "NoEditorID",
-				a_sourcePart->formID,
-				a_newHeadPart->GetFormEditorID() ? a_newHeadPart->GetFormEditorID() : "NoEditorID",
-				a_newHeadPart->formID);
+			if (allForms->emplace(legacyFormID, headPart).second) {
+				aliasCount++;
+				if (verboseLogging) {
+					logger::info("Aliased legacy FormID {:08X} to '{}' ({:08X})", legacyFormID, headPart->GetFormEditorID(), headPart->formID);
+				}
+			} else if (verboseLogging) {
+				logger::warn("Legacy FormID {:08X} of '{}' is already in use. Saves referencing it will not resolve.", legacyFormID, headPart->GetFormEditorID());
+			}
 		}
 
-		for (const auto* extraPart : extraParts) {
-			if (!extraPart) {
-				if (verboseLogging) {
-					logger::warn("Null extra part found in source head part {} [{:08X}]",
-						a_sourcePart->GetFormEditorID() ? a_sourcePart->GetFormEditorID() : "NoEditorID",
-						a_sourcePart->formID);
+		return aliasCount;
+	}
+
+	GenerationPlan BuildPlan(
+		const std::vector<CreatedHeadPart>& a_createdParts,
+		std::vector<RE::FormID> a_disabledParts,
+		std::vector<PluginFingerprint> a_plugins)
+	{
+		GenerationPlan plan;
+		plan.headParts.reserve(a_createdParts.size());
+
+		for (const auto& [source, headPart, legacyFormID] : a_createdParts) {
+			auto& planned = plan.headParts.emplace_back();
+			planned.sourceFormID = source->formID;
+			planned.formID = headPart->formID;
+			planned.legacyFormID = legacyFormID;
+			planned.editorID = headPart->GetFormEditorID();  // Owned by the form, which outlives the plan
+			planned.toFemale = headPart->flags.all(RE::BGSHeadPart::Flag::kFemale);
+			planned.extraPartsBegin = static_cast<std::uint32_t>(plan.extraParts.size());
+			for (const auto* extraPart : headPart->extraParts) {
+				if (extraPart) {
+					plan.extraParts.push_back(extraPart->formID);
 				}
-				continue;
 			}
+			planned.extraPartsCount = static_cast<std::uint32_t>(plan.extraParts.size()) - planned.extraPartsBegin;
+		}
 
-			// Analyze extra part gender compatibility
-			const auto extraFlags = extraPart->flags;
-			const bool extraIsMale = extraFlags.all(RE::BGSHeadPart::Flag::kMale);
-			const bool extraIsFemale = extraFlags.all(RE::BGSHeadPart::Flag::kFemale);
-			const bool extraIsGenderless = !extraIsMale && !extraIsFemale;
+		plan.disabledParts = std::move(a_disabledParts);
+		plan.plugins = std::move(a_plugins);
+		return plan;
+	}
 
-			// Determine if gender flip is needed
-			bool needsGenderFlip = false;
+	GenerationPlan SelectUnchangedParts(
+		const GenerationCacheFormat::View& a_cachedPlan,
+		std::span<const PluginFingerprint> a_currentPlugins,
+		std::unordered_set<const RE::TESFile*>& a_outUnchangedFiles)
+	{
+		auto& dataHandler = *RE::TESDataHandler::GetSingleton();
 
-			if (!extraIsGenderless) {
-				needsGenderFlip = (extraIsMale && targetIsFemale) || (extraIsFemale && !targetIsFemale);
+		// A plugin is unchanged if it had the same fingerprint when the plan was generated
+		GenerationPlan plan;
+		const auto cachedPlugins = a_cachedPlan.GetPlugins();
+		for (const auto& current : a_currentPlugins) {
+			const auto it = std::ranges::find_if(cachedPlugins, [&](const PluginFingerprint& a_cached) {
+				return a_cached.fingerprint == current.fingerprint && string::iequals(a_cached.fileName, current.fileName);
+			});
+			if (it == cachedPlugins.end()) {
+				continue;
 			}
 
-			if (!needsGenderFlip) {
-				newExtraParts.push_back(const_cast<RE::BGSHeadPart*>(extraPart));
-				if (verboseLogging) {
-					logger::debug("Using original extra part: {} [{:08X}] (Type: {})",
-						extraPart->GetFormEditorID() ? extraPart->GetFormEditorID() : "NoEditorID",
-						extraPart->formID,
-						Settings::GetHeadPartTypeName(static_cast<RE::BGSHeadPart::HeadPartType>(extraPart->type.get())));
-				}
+			const auto* file = dataHandler.LookupLoadedModByName(current.fileName);
+			if (!file) {
+				file = dataHandler.LookupLoadedLightModByName(current.fileName);
+			}
+			if (file) {
+				a_outUnchangedFiles.insert(file);
+				plan.plugins.push_back(current);
+			}
+		}
+		if (a_outUnchangedFiles.empty()) {
+			return plan;
+		}
+
+		// A corrupted record makes the whole cache untrustworthy
+		const auto discard = [&] {
+			a_outUnchangedFiles.clear();
+			return GenerationPlan{};
+		};
+
+		// Only the records of unchanged plugins are copied out of the cache
+		// New parts live in the plugin providing their source's winning record, so their FormID identifies it
+		for (std::uint32_t i = 0; i < a_cachedPlan.GetPartCount(); ++i) {
+			const auto planned = a_cachedPlan.GetPart(i);
+			if (!planned) {
+				return discard();
+			}
+			if (planned->formID == 0 || planned->sourceFormID == 0 || !a_outUnchangedFiles.contains(GetFileFromFormID(planned->formID))) {
 				continue;
 			}
 
-			// Generate EditorID for gender-flipped extra part
-			const char* extraEditorID = extraPart->GetFormEditorID();
-			std::string newEditorID;
-			if (extraEditorID) {
-				newEditorID.reserve(strlen(extraEditorID) + 8);
-				newEditorID = extraEditorID;
-				newEditorID += "_Unisexy";
-			} else {
-				newEditorID = fmt::format("ExtraPart_{:08X}_Unisexy", extraPart->formID);
+			auto& kept = plan.headParts.emplace_back(*planned);
+			kept.extraPartsBegin = static_cast<std::uint32_t>(plan.extraParts.size());
+			for (std::uint32_t j = 0; j < planned->extraPartsCount; ++j) {
+				const auto extraFormID = a_cachedPlan.GetExtraPart(planned->extraPartsBegin + j);
+				if (!extraFormID) {
+					return discard();
+				}
+				plan.extraParts.push_back(*extraFormID);
+			}
+		}
+
+		for (std::uint32_t i = 0; i < a_cachedPlan.GetDisabledCount(); ++i) {
+			const auto formID = a_cachedPlan.GetDisabledPart(i);
+			if (!formID) {
+				return discard();
+			}
+			const auto* headPart = *formID != 0 ? RE::TESForm::LookupByID<RE::BGSHeadPart>(*formID) : nullptr;
+			if (headPart && a_outUnchangedFiles.contains(headPart->GetFile())) {
+				plan.disabledParts.push_back(*formID);
+			}
+		}
+
+		return plan;
+	}
+
+	bool InstantiatePlan(
+		RE::IFormFactory* a_factory,
+		const GenerationPlan& a_plan,
+		const Settings& a_settings,
+		bool a_isCached,
+		std::vector<CreatedHeadPart>& a_createdParts,
+		std::vector<RE::FormID>& a_disabledParts)
+	{
+		assert(a_factory);
+
+		const bool verboseLogging = a_settings.IsVerboseLogging();
+
+		// A cached plan is validated as a whole before anything is created, so a stale plan can fall back to regeneration
+		// A freshly planned part that can't be created is skipped on its own, leaving it out of its parents' extra parts
+		std::unordered_set<RE::FormID> plannedFormIDs;
+		if (a_isCached) {
+			plannedFormIDs.reserve(a_plan.headParts.size());
+			for (const auto& planned : a_plan.headParts) {
+				plannedFormIDs.insert(planned.formID);
 			}
+		}
 
-			// Check if we already created this extra part
-			auto existingIt = a_existingEditorIDs.find(newEditorID);
-			if (existingIt != a_existingEditorIDs.end()) {
-				// Search for existing version to reuse
-				bool foundExisting = false;
-				for (const auto& existingHeadPart : dataHandler.GetFormArray<RE::BGSHeadPart>()) {
-					if (existingHeadPart && existingHeadPart->GetFormEditorID()) {
-						const char* existingID = existingHeadPart->GetFormEditorID();
-						if (existingID && newEditorID == existingID) {
-							newExtraParts.push_back(existingHeadPart);
-							foundExisting = true;
-							if (verboseLogging) {
-								logger::info("Reusing existing extra part: {} [{:08X}] (Type: {}) for head part {} [{:08X}]",
-									newEditorID,
-									existingHeadPart->formID,
-									Settings::GetHeadPartTypeName(static_cast<RE::BGSHeadPart::HeadPartType>(existingHeadPart->type.get())),
-									a_newHeadPart->GetFormEditorID() ? a_newHeadPart->GetFormEditorID() : "NoEditorID",
-									a_newHeadPart->formID);
-							}
-							break;
-						}
+		std::vector<std::pair<const RE::BGSHeadPart*, const RE::TESFile*>> sources;
+		sources.reserve(a_plan.headParts.size());
+		for (const auto& planned : a_plan.headParts) {
+			const auto* source = RE::TESForm::LookupByID<RE::BGSHeadPart>(planned.sourceFormID);
+			const auto* targetFile = GetFileFromFormID(planned.formID);
+			bool isValid = true;
+			if (!source || !targetFile || planned.editorID.empty()) {
+				logger::info("Planned head part {} [{:08X}] can no longer be created from source [{:08X}]",
+					planned.editorID, planned.formID, planned.sourceFormID);
+				isValid = false;
+			} else if (RE::TESForm::LookupByID(planned.formID)) {
+				logger::info("Planned FormID [{:08X}] for {} is already in use", planned.formID, planned.editorID);
+				isValid = false;
+			} else if (a_isCached) {
+				for (const auto extraFormID : a_plan.GetExtraParts(planned)) {
+					if (!plannedFormIDs.contains(extraFormID) && !RE::TESForm::LookupByID<RE::BGSHeadPart>(extraFormID)) {
+						logger::info("Extra part [{:08X}] of {} no longer exists", extraFormID, planned.editorID);
+						isValid = false;
+						break;
 					}
 				}
+			}
 
-				if (!foundExisting) {
-					// Fall back to original if we can't find the existing version
-					newExtraParts.push_back(const_cast<RE::BGSHeadPart*>(extraPart));
-					if (verboseLogging) {
-						logger::warn("Could not find existing extra part {}, using original {} [{:08X}]",
-							newEditorID,
-							extraPart->GetFormEditorID() ? extraPart->GetFormEditorID() : "NoEditorID",
-							extraPart->formID);
-					}
+			if (!isValid) {
+				if (a_isCached) {
+					return false;
 				}
+				sources.emplace_back(nullptr, nullptr);
 				continue;
 			}
-
-			// Create new gender-flipped extra part
-			auto* newExtraPart = CreateUnisexyHeadPart(
-				headFactory, extraPart, newEditorID, targetIsFemale, a_settings);
-
-			if (!newExtraPart) {
-				// Fall back to original extra part if creation fails
-				newExtraParts.push_back(const_cast<RE::BGSHeadPart*>(extraPart));
-				logger::error("Failed to create gender-flipped extra part for {} [{:08X}] (Source: {} [{:08X}])",
-					extraPart->GetFormEditorID() ? extraPart->GetFormEditorID() : "NoEditorID",
-					extraPart->formID,
-					a_sourcePart->GetFormEditorID() ? a_sourcePart->GetFormEditorID() : "NoEditorID",
-					a_sourcePart->formID);
-				a_conflictDetails.emplace_back(newEditorID, 0, 0);  // Record failure
+			sources.emplace_back(source, targetFile);
+		}
+		const auto createdBefore = a_createdParts.size();
+		a_createdParts.reserve(createdBefore + a_plan.headParts.size());
+
+		// Create every planned head part with its planned FormID
+		std::unordered_map<RE::FormID, RE::BGSHeadPart*> createdParts;
+		createdParts.reserve(a_plan.headParts.size());
+		std::vector<std::pair<const PlannedHeadPart*, RE::BGSHeadPart*>> created;
+		created.reserve(a_plan.headParts.size());
+		std::unordered_set<RE::FormID> missingSources;  // Sources whose flipped version was not created
+
+		for (std::size_t i = 0; i < a_plan.headParts.size(); ++i) {
+			const auto& planned = a_plan.headParts[i];
+			const auto& [source, targetFile] = sources[i];
+			if (!source) {
+				missingSources.insert(planned.sourceFormID);
 				continue;
 			}
 
-			// Assign FormID and register with data handler
-			std::uint32_t conflictFormID = 0;
-
-			if (!a_formIDManager.AssignFormID(newExtraPart, a_targetFile, conflictFormID)) {
-				a_conflictDetails.emplace_back(newEditorID, conflictFormID, 0);
-				logger::error("Failed to assign FormID for extra part {} (Source: {} [{:08X}])",
-					newEditorID,
-					a_sourcePart->GetFormEditorID() ? a_sourcePart->GetFormEditorID() : "NoEditorID",
-					a_sourcePart->formID);
-				delete newExtraPart;
-				newExtraParts.push_back(const_cast<RE::BGSHeadPart*>(extraPart));
+			auto* newHeadPart = CreateUnisexyHeadPart(a_factory, source, planned.editorID, planned.toFemale, targetFile, a_settings);
+			if (!newHeadPart) {
+				missingSources.insert(planned.sourceFormID);
 				continue;
 			}
 
-			// Store conflict details if there was a conflict
-			if (conflictFormID != 0) {
-				a_conflictDetails.emplace_back(newEditorID, conflictFormID, newExtraPart->formID);
-			}
+			newHeadPart->SetFormID(planned.formID, false);
+			newHeadPart->SetFile(const_cast<RE::TESFile*>(targetFile));
+			createdParts.emplace(planned.formID, newHeadPart);
+			created.emplace_back(&planned, newHeadPart);
+			a_createdParts.push_back({ source, newHeadPart, planned.legacyFormID });
+		}
 
-			// Set the file for the new extra part
-			newExtraPart->SetFile(const_cast<RE::TESFile*>(a_targetFile));
-			dataHandler.AddFormToDataHandler(newExtraPart);
-			a_existingEditorIDs.insert(newEditorID);
-			newExtraParts.push_back(newExtraPart);
-			a_createdCount++;
+		// Wire extra parts now that every planned part exists
+		std::vector<RE::BGSHeadPart*> headParts;
+		headParts.reserve(created.size());
+		for (const auto& [planned, newHeadPart] : created) {
+			RE::BSTArray<RE::BGSHeadPart*> extraParts;
+			extraParts.reserve(planned->extraPartsCount);
+			for (const auto extraFormID : a_plan.GetExtraParts(*planned)) {
+				const auto it = createdParts.find(extraFormID);
+				auto* extraPart = it != createdParts.end() ? it->second : RE::TESForm::LookupByID<RE::BGSHeadPart>(extraFormID);
+				if (extraPart) {
+					extraParts.push_back(extraPart);
+				}
+			}
+			newHeadPart->extraParts = std::move(extraParts);
+			headParts.push_back(newHeadPart);
 
 			if (verboseLogging) {
-				logger::info("Created extra part: {} [{:08X}] (Type: {}) for head part {} [{:08X}] (Source: {} [{:08X}])",
-					newEditorID,
-					newExtraPart->formID,
-					Settings::GetHeadPartTypeName(static_cast<RE::BGSHeadPart::HeadPartType>(newExtraPart->type.get())),
-					a_newHeadPart->GetFormEditorID() ? a_newHeadPart->GetFormEditorID() : "NoEditorID",
-					a_newHeadPart->formID,
-					a_sourcePart->GetFormEditorID() ? a_sourcePart->GetFormEditorID() : "NoEditorID",
-					a_sourcePart->formID);
+				logger::info("Created head part: {} [{:08X}] from source [{:08X}]",
+					planned->editorID, planned->formID, planned->sourceFormID);
 			}
 		}
 
-		// Assign all processed extra parts to the new head part
-		a_newHeadPart->extraParts = std::move(newExtraParts);
+		RegisterHeadParts(headParts);
+
+		// Keep FormIDs stored in saves from older builds resolving
+		if (a_settings.GetFormIDHashMode() == FormIDUtils::HashMode::kMigrate) {
+			const auto aliasCount = RegisterLegacyFormIDAliases(std::span(a_createdParts).subspan(createdBefore));
+			logger::info("Registered {} legacy FormID aliases", aliasCount);
+		}
+
+		// Hide the originals that were hidden by the plan, unless their flipped version is missing
+		for (const auto formID : a_plan.disabledParts) {
+			auto* headPart = !missingSources.contains(formID) ? RE::TESForm::LookupByID<RE::BGSHeadPart>(formID) : nullptr;
+			if (headPart) {
+				headPart->flags.reset(RE::BGSHeadPart::Flag::kPlayable);
+				a_disabledParts.push_back(formID);
+			}
+		}
+
+		if (created.size() != a_plan.headParts.size()) {
+			logger::error("Failed to create {} planned head parts", a_plan.headParts.size() - created.size());
+		}
+
 		return true;
 	}
 }
@@ -1,35 +1,69 @@
 #pragma once
 
-#include "FormIDManager.h"
+#include "FormIDUtils.h"
+#include "GenerationCacheFormat.h"
+#include "GenerationPlan.h"
 #include "RE/B/BGSHeadPart.h"
 #include "RE/Skyrim.h"
 #include "Settings.h"
 
 namespace HeadPartUtils
 {
-	// Generate a Unisexy EditorID for the given head part
-	// Returns empty string if the head part has no EditorID
-	std::string GenerateUnisexyEditorID(const RE::BGSHeadPart* a_headPart);
+	// A head part created during a generation pass and the part it was cloned from
+	struct CreatedHeadPart
+	{
+		const RE::BGSHeadPart* source = nullptr;
+		RE::BGSHeadPart* headPart = nullptr;
+		RE::FormID legacyFormID = 0;  // FormID an older build assigned to the part; 0 if none
+	};
+
+	// Determine which loaded plugin a FormID belongs to
+	// Returns nullptr if the FormID doesn't correspond to a loaded plugin
+	const RE::TESFile* GetFileFromFormID(RE::FormID a_formID);
 
 	// Create a gender-flipped copy of the source head part
+	// a_newEditorID must be NUL-terminated; a_targetFile is the plugin the part will be placed in
 	// Returns nullptr only if memory allocation fails
 	RE::BGSHeadPart* CreateUnisexyHeadPart(
 		RE::IFormFactory* a_factory,
 		const RE::BGSHeadPart* a_sourcePart,
-		const std::string& a_newEditorID,
+		std::string_view a_newEditorID,
 		bool a_toFemale,
+		const RE::TESFile* a_targetFile,
 		const Settings& a_settings);
 
-	// Process and create gender-flipped versions of extra parts
-	// Updates a_createdCount with number of extra parts created
-	// Appends FormID conflict details to a_conflictDetails
-	bool ProcessExtraParts(
-		RE::BGSHeadPart* a_newHeadPart,
-		const RE::BGSHeadPart* a_sourcePart,
-		FormIDManager& a_formIDManager,
-		const RE::TESFile* a_targetFile,
-		std::set<std::string>& a_existingEditorIDs,
+	// Register new head parts with the data handler in the given order
+	// Only the growth of the head part array is batched; each form still goes through AddFormToDataHandler
+	void RegisterHeadParts(std::span<RE::BGSHeadPart* const> a_headParts);
+
+	// Make the FormIDs older builds assigned resolve to the created head parts as well
+	// The alias is a second key for the same form in the global form map, and is never added over an existing form
+	// Returns the number of aliases added
+	std::size_t RegisterLegacyFormIDAliases(std::span<const CreatedHeadPart> a_createdParts);
+
+	// Record the head parts created by a generation pass as a replayable plan
+	GenerationPlan BuildPlan(
+		const std::vector<CreatedHeadPart>& a_createdParts,
+		std::vector<RE::FormID> a_disabledParts,
+		std::vector<PluginFingerprint> a_plugins);
+
+	// Copy the part of a cached plan that belongs to plugins whose fingerprint is unchanged out of the cache
+	// Adds those plugins to a_outUnchangedFiles; their head parts need no regeneration
+	// If a record it reads is corrupted, a_outUnchangedFiles is cleared and nothing is selected
+	GenerationPlan SelectUnchangedParts(
+		const GenerationCacheFormat::View& a_cachedPlan,
+		std::span<const PluginFingerprint> a_currentPlugins,
+		std::unordered_set<const RE::TESFile*>& a_outUnchangedFiles);
+
+	// Create the head parts of a plan, either freshly generated or restored from the cache
+	// A cached plan is validated as a whole first, and nothing is created if any part can no longer be created
+	// Parts of a fresh plan that can't be created are skipped; the caller counts them as missing from a_createdParts
+	// Appends the created parts to a_createdParts and the originals it hid to a_disabledParts
+	bool InstantiatePlan(
+		RE::IFormFactory* a_factory,
+		const GenerationPlan& a_plan,
 		const Settings& a_settings,
-		int& a_createdCount,
-		std::vector<std::tuple<std::string, std::uint32_t, std::uint32_t>>& a_conflictDetails);
+		bool a_isCached,
+		std::vector<CreatedHeadPart>& a_createdParts,
+		std::vector<RE::FormID>& a_disabledParts);
 }
@@ -0,0 +1,108 @@
+#include "MemoryHeadPartSource.h"
+#include "CorePCH.h"
+#include "FormIDUtils.h"
+
+const PluginInfo* MemoryHeadPartSource::AddPlugin(std::string_view a_fileName, bool a_isLight)
+{
+	assert(!finalized_);
+
+	auto& plugin = plugins_.emplace_back();
+	plugin.fileName = strings_.Intern(a_fileName);
+	plugin.compileIndex = a_isLight ? lightPluginCount_++ : fullPluginCount_++;
+	plugin.isLight = a_isLight;
+	return &plugin;
+}
+
+FormID MemoryHeadPartSource::AddHeadPart(
+	const PluginInfo* a_file,
+	std::uint32_t a_localID,
+	std::string_view a_editorID,
+	HeadPartType a_type,
+	std::uint8_t a_flags,
+	const PluginInfo* a_originFile)
+{
+	assert(!finalized_ && a_file);
+
+	auto& headPart = headParts_.emplace_back();
+	headPart.formID = FormIDUtils::MakeFormID(a_file->compileIndex, a_file->isLight, a_localID);
+	headPart.editorID = a_editorID.empty() ? std::string_view{} : strings_.Intern(a_editorID);
+	headPart.type = a_type;
+	headPart.flags = a_flags;
+	headPart.file = a_file;
+	headPart.originFile = a_originFile ? a_originFile : a_file;
+	headPartIndices_.emplace(headPart.formID, headParts_.size() - 1);
+	return headPart.formID;
+}
+
+void MemoryHeadPartSource::AddExtraPart(FormID a_headPart, FormID a_extraPart)
+{
+	assert(!finalized_ && headPartIndices_.contains(a_headPart) && headPartIndices_.contains(a_extraPart));
+	extraPartLinks_.emplace_back(a_headPart, a_extraPart);
+}
+
+void MemoryHeadPartSource::AddForm(FormID a_formID, std::string_view a_editorID)
+{
+	assert(!finalized_);
+	forms_.emplace(a_formID, a_editorID.empty() ? std::string_view{} : strings_.Intern(a_editorID));
+}
+
+void MemoryHeadPartSource::Finalize()
+{
+	assert(!finalized_);
+
+	// Group the links by head part, keeping the order they were added in
+	std::ranges::stable_sort(extraPartLinks_, {}, [this](const auto& a_link) { return headPartIndices_.at(a_link.first); });
+
+	extraParts_.reserve(extraPartLinks_.size());
+	for (const auto& [headPartID, extraPartID] : extraPartLinks_) {
+		extraParts_.push_back(&headParts_[headPartIndices_.at(extraPartID)]);
+	}
+
+	for (std::size_t begin = 0; begin < extraPartLinks_.size();) {
+		const auto headPartID = extraPartLinks_[begin].first;
+		std::size_t end = begin;
+		while (end < extraPartLinks_.size() && extraPartLinks_[end].first == headPartID) {
+			++end;
+		}
+		headParts_[headPartIndices_.at(headPartID)].extraParts = std::span(extraParts_).subspan(begin, end - begin);
+		begin = end;
+	}
+
+	finalized_ = true;
+}
+
+std::span<const HeadPartRecord> MemoryHeadPartSource::GetHeadParts() const
+{
+	assert(finalized_);
+	return headParts_;
+}
+
+const HeadPartRecord* MemoryHeadPartSource::FindHeadPart(FormID a_formID) const
+{
+	const auto it = headPartIndices_.find(a_formID);
+	return it != headPartIndices_.end() ? &headParts_[it->second] : nullptr;
+}
+
+void MemoryHeadPartSource::ForEachFormID(const std::function<void(FormID)>& a_visitor) const
+{
+	for (const auto& headPart : headParts_) {
+		a_visitor(headPart.formID);
+	}
+	for (const auto& [formID, editorID] : forms_) {
+		a_visitor(formID);
+	}
+}
+
+bool MemoryHeadPartSource::HasForm(FormID a_formID) const
+{
+	return headPartIndices_.contains(a_formID) || forms_.contains(a_formID);
+}
+
+std::string_view MemoryHeadPartSource::GetEditorID(FormID a_formID) const
+{
+	if (const auto* headPart = FindHeadPart(a_formID)) {
+		return headPart->editorID;
+	}
+	const auto it = forms_.find(a_formID);
+	return it != forms_.end() ? it->second : std::string_view{};
+}
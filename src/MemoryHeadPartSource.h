@@ -0,0 +1,51 @@
+#pragma once
+
+#include "HeadPartSource.h"
+#include "StringArena.h"
+
+// Head part source assembled in memory, for tests and benchmarks
+// Add plugins, head parts, extra part links and other forms, then Finalize before use
+class MemoryHeadPartSource : public IHeadPartSource
+{
+public:
+	// Load a plugin; compile indices are handed out in load order, separately for light plugins
+	const PluginInfo* AddPlugin(std::string_view a_fileName, bool a_isLight);
+
+	// Add a head part to the end of the form array and return its FormID
+	// a_originFile is the plugin defining the record, if another plugin overrides it
+	FormID AddHeadPart(
+		const PluginInfo* a_file,
+		std::uint32_t a_localID,
+		std::string_view a_editorID,
+		HeadPartType a_type,
+		std::uint8_t a_flags,
+		const PluginInfo* a_originFile = nullptr);
+
+	// Append an extra part to a head part; both must have been added
+	void AddExtraPart(FormID a_headPart, FormID a_extraPart);
+
+	// Occupy a FormID with a form that is not a head part
+	void AddForm(FormID a_formID, std::string_view a_editorID = {});
+
+	// Wire the extra parts; nothing may be added afterwards
+	void Finalize();
+
+	std::span<const HeadPartRecord> GetHeadParts() const override;
+	const HeadPartRecord* FindHeadPart(FormID a_formID) const override;
+	void ForEachFormID(const std::function<void(FormID)>& a_visitor) const override;
+	bool HasForm(FormID a_formID) const override;
+	std::string_view GetEditorID(FormID a_formID) const override;
+
+private:
+	StringArena strings_;
+	std::deque<PluginInfo> plugins_;
+	std::uint32_t fullPluginCount_ = 0;
+	std::uint32_t lightPluginCount_ = 0;
+
+	std::vector<HeadPartRecord> headParts_;
+	std::unordered_map<FormID, std::size_t> headPartIndices_;
+	std::vector<std::pair<FormID, FormID>> extraPartLinks_;  // Head part, extra part
+	std::vector<const HeadPartRecord*> extraParts_;          // Extra parts of all head parts, back to back
+	std::unordered_map<FormID, std::string_view> forms_;     // Forms that are not head parts
+	bool finalized_ = false;
+};
@@ -0,0 +1,120 @@
+#pragma once
+
+// Accumulates wall-clock time spent in each phase of a generation pass
+class PhaseTimer
+{
+public:
+	enum class Phase : std::uint32_t
+	{
+		kCacheLoad,     // Generation cache lookup and restore
+		kSnapshot,      // Snapshotting the head parts the planner reads
+		kIndexBuild,    // EditorID index construction
+		kClassify,      // Parallel read-only classification of all head parts
+		kFormIDScan,    // Indexing FormIDs already taken in the target plugins
+		kFlipLoop,      // Serial planning loop, including the phases below
+		kAssignFormID,  // FormID assignment and conflict probing
+		kExtraParts,    // Extra part discovery and planning
+		kCreate,        // Creating and registering every planned head part
+		kSummary,       // End of run summary logging
+		kCacheSave,     // Writing the generation cache
+		kReport,        // Writing the generation report
+
+		kTotal
+	};
+
+	// Adds the time between construction and destruction to a phase
+	class Scope
+	{
+	public:
+		Scope(PhaseTimer& a_timer, Phase a_phase) :
+			timer_(a_timer),
+			phase_(a_phase),
+			start_(std::chrono::steady_clock::now())
+		{}
+
+		~Scope()
+		{
+			timer_.Add(phase_, std::chrono::steady_clock::now() - start_);
+		}
+
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+
+	private:
+		PhaseTimer& timer_;
+		Phase phase_;
+		std::chrono::steady_clock::time_point start_;
+	};
+
+	// Start timing a phase until the returned scope is destroyed
+	[[nodiscard]] Scope Measure(Phase a_phase) { return Scope(*this, a_phase); }
+
+	// Add an externally measured duration to a phase
+	void Add(Phase a_phase, std::chrono::steady_clock::duration a_duration)
+	{
+		const auto index = std::to_underlying(a_phase);
+		durations_[index] += a_duration;
+		counts_[index]++;
+	}
+
+	// Total milliseconds spent in a phase
+	double GetMilliseconds(Phase a_phase) const
+	{
+		return std::chrono::duration<double, std::milli>(durations_[std::to_underlying(a_phase)]).count();
+	}
+
+	// Number of times a phase was entered
+	std::uint32_t GetCount(Phase a_phase) const
+	{
+		return counts_[std::to_underlying(a_phase)];
+	}
+
+	// Log the time spent in every phase that was entered
+	void LogSummary() const
+	{
+		logger::info("Phase timings:");
+		for (std::uint32_t i = 0; i < std::to_underlying(Phase::kTotal); ++i) {
+			const auto phase = static_cast<Phase>(i);
+			if (GetCount(phase) > 0) {
+				logger::info("  {}: {:.2f} ms ({} calls)", GetPhaseName(phase), GetMilliseconds(phase), GetCount(phase));
+			}
+		}
+	}
+
+	// Get human-readable name for a phase
+	static std::string_view GetPhaseName(Phase a_phase)
+	{
+		switch (a_phase) {
+		case Phase::kCacheLoad:
+			return "Generation cache load";
+		case Phase::kSnapshot:
+			return "Head part snapshot";
+		case Phase::kIndexBuild:
+			return "EditorID index build";
+		case Phase::kClassify:
+			return "Classification";
+		case Phase::kFormIDScan:
+			return "FormID pre-scan";
+		case Phase::kFlipLoop:
+			return "Planning loop (total)";
+		case Phase::kAssignFormID:
+			return "  AssignFormID";
+		case Phase::kExtraParts:
+			return "  Extra parts";
+		case Phase::kCreate:
+			return "Create and register";
+		case Phase::kSummary:
+			return "Summary";
+		case Phase::kCacheSave:
+			return "Generation cache save";
+		case Phase::kReport:
+			return "Generation report";
+		default:
+			return "Unknown";
+		}
+	}
+
+private:
+	std::array<std::chrono::steady_clock::duration, std::to_underlying(Phase::kTotal)> durations_{};
+	std::array<std::uint32_t, std::to_underlying(Phase::kTotal)> counts_{};
+};
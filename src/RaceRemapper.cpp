@@ -0,0 +1,185 @@
+#include "RaceRemapper.h"
+#include "PCH.h"
+
+#include "FormIDManager.h"
+#include "GameHeadPartSource.h"
+
+void RaceRemapper::Build(const Settings& a_settings)
+{
+	if (_built) {
+		return;
+	}
+	_built = true;
+
+	auto& dataHandler = *RE::TESDataHandler::GetSingleton();
+	for (std::size_t direction = 0; direction < _remaps.size(); ++direction) {
+		auto& remap = _remaps[direction];
+		for (const auto& [raceName, replacementNames] : a_settings.GetRaceRemap(direction == 1)) {
+			const auto* race = FindRace(dataHandler, raceName);
+			if (!race) {
+				logger::warn("Unknown race '{}' in race remapping rules", raceName);
+				continue;
+			}
+
+			// Repeated keys for the same race add up
+			auto& replacements = remap[race];
+			for (const auto& replacementName : replacementNames) {
+				auto* replacement = FindRace(dataHandler, replacementName);
+				if (!replacement) {
+					logger::warn("Unknown race '{}' in race remapping rule for '{}'", replacementName, raceName);
+					continue;
+				}
+				if (std::ranges::find(replacements, replacement) == replacements.end()) {
+					replacements.push_back(replacement);
+				}
+			}
+		}
+	}
+
+	if (!_remaps[0].empty() || !_remaps[1].empty()) {
+		logger::info("Loaded race remapping rules for {} races to male and {} races to female", _remaps[0].size(), _remaps[1].size());
+	}
+}
+
+RE::BGSListForm* RaceRemapper::GetValidRaces(RE::BGSListForm* a_sourceList, bool a_toFemale, const RE::TESFile* a_targetFile)
+{
+	if (!a_sourceList || _remaps[a_toFemale ? 1 : 0].empty()) {
+		return a_sourceList;
+	}
+
+	const Key key{ a_sourceList, a_toFemale };
+	auto it = _lists.find(key);
+	if (it == _lists.end()) {
+		it = _lists.emplace(key, BuildList(a_sourceList, a_toFemale)).first;
+		if (it->second) {
+			_pendingLists.push_back({ it->second, a_sourceList, a_toFemale, a_targetFile });
+			_listCount++;
+		}
+	}
+	return it->second ? it->second : a_sourceList;
+}
+
+void RaceRemapper::RegisterLists(const Settings& a_settings)
+{
+	if (_pendingLists.empty()) {
+		return;
+	}
+
+	auto& dataHandler = *RE::TESDataHandler::GetSingleton();
+
+	// Reserve FormIDs the way head parts get theirs, against every form loaded so far
+	const GameHeadPartSource source(dataHandler);
+	FormIDManager formIDManager(source, a_settings.GetFormIDHashMode(), a_settings.IsVerboseLogging());
+	std::unordered_map<const RE::TESFile*, PluginInfo> plugins;
+
+	for (const auto& [list, sourceList, toFemale, targetFile] : _pendingLists) {
+		if (!targetFile) {
+			logger::error("Remapped race list for [{:08X}] has no plugin to be placed in", sourceList->formID);
+			continue;
+		}
+
+		auto [pluginIt, inserted] = plugins.try_emplace(targetFile);
+		auto& plugin = pluginIt->second;
+		if (inserted) {
+			plugin.fileName = targetFile->GetFilename();
+			plugin.isLight = targetFile->IsLight();
+			plugin.compileIndex = plugin.isLight ? targetFile->smallFileCompileIndex : targetFile->compileIndex;
+		}
+
+		// Derived from the source list so the FormID is the same on every launch with the same load order
+		const auto* sourceFile = sourceList->GetFile(0);
+		const auto editorID = sourceFile ?
+		                          fmt::format("Unisexy{}Races_{}_{:06X}", toFemale ? "Female" : "Male", sourceFile->GetFilename(), sourceList->GetLocalFormID()) :
+		                          fmt::format("Unisexy{}Races_{:08X}", toFemale ? "Female" : "Male", sourceList->formID);
+		std::uint32_t conflictFormID = 0;
+		const auto formID = formIDManager.AssignFormID(Hash::HashedKey(editorID), &plugin, conflictFormID);
+		if (formID == 0) {
+			logger::error("No FormID left in {} for the remapped race list of [{:08X}]", plugin.fileName, sourceList->formID);
+			continue;
+		}
+
+		list->SetFormID(formID, false);
+		list->SetFile(const_cast<RE::TESFile*>(targetFile));
+		dataHandler.AddFormToDataHandler(list);
+	}
+	_pendingLists.clear();
+}
+
+RE::TESRace* RaceRemapper::FindRace(RE::TESDataHandler& a_dataHandler, std::string_view a_race)
+{
+	// Plugin.esp|0x123 names a race by its FormID within the plugin
+	if (const auto separator = a_race.find('|'); separator != std::string_view::npos) {
+		const auto trim = [](std::string_view a_text) {
+			const auto first = a_text.find_first_not_of(" \t");
+			return first == std::string_view::npos ? std::string_view{} : a_text.substr(first, a_text.find_last_not_of(" \t") - first + 1);
+		};
+		const auto fileName = trim(a_race.substr(0, separator));
+		auto localIDText = trim(a_race.substr(separator + 1));
+		if (localIDText.starts_with("0x") || localIDText.starts_with("0X")) {
+			localIDText.remove_prefix(2);
+		}
+
+		RE::FormID localID = 0;
+		const auto [ptr, ec] = std::from_chars(localIDText.data(), localIDText.data() + localIDText.size(), localID, 16);
+		const auto* file = a_dataHandler.LookupModByName(fileName);
+		if (ec != std::errc{} || ptr != localIDText.data() + localIDText.size() || !file) {
+			return nullptr;
+		}
+		// LookupForm adds the plugin's index itself, so a full FormID is cut down to its local part
+		return a_dataHandler.LookupForm<RE::TESRace>(localID & FormIDUtils::GetMaxLocalID(file->IsLight()), fileName);
+	}
+
+	// LookupByEditorID only finds the few form types whose EditorIDs the engine keeps in its map, but races keep their own
+	for (auto* race : a_dataHandler.GetFormArray<RE::TESRace>()) {
+		const char* editorID = race ? race->GetFormEditorID() : nullptr;
+		if (editorID && string::iequals(editorID, a_race)) {
+			return race;
+		}
+	}
+	return nullptr;
+}
+
+RE::BGSListForm* RaceRemapper::BuildList(const RE::BGSListForm* a_sourceList, bool a_toFemale) const
+{
+	const auto& remap = _remaps[a_toFemale ? 1 : 0];
+
+	// Leave lists without a remapped race alone so they stay shared with the source parts
+	const bool hasRemappedRace = std::ranges::any_of(a_sourceList->forms, [&](RE::TESForm* a_form) {
+		return a_form && remap.contains(a_form->As<RE::TESRace>());
+	});
+	if (!hasRemappedRace) {
+		return nullptr;
+	}
+
+	const auto factory = RE::IFormFactory::GetConcreteFormFactoryByType<RE::BGSListForm>();
+	auto* list = factory ? static_cast<RE::BGSListForm*>(factory->Create()) : nullptr;
+	if (!list) {
+		logger::error("Failed to create remapped race list for [{:08X}] - memory allocation failed", a_sourceList->formID);
+		return nullptr;
+	}
+
+	// Replace each remapped race in place, keeping the order and dropping duplicates
+	for (auto* form : a_sourceList->forms) {
+		if (!form) {
+			continue;
+		}
+		const auto it = remap.find(form->As<RE::TESRace>());
+		if (it == remap.end()) {
+			if (std::ranges::find(list->forms, form) == list->forms.end()) {
+				list->forms.push_back(form);
+			}
+			continue;
+		}
+		for (auto* replacement : it->second) {
+			if (std::ranges::find(list->forms, replacement) == list->forms.end()) {
+				list->forms.push_back(replacement);
+			}
+		}
+	}
+
+	if (Settings::GetSingleton()->IsVerboseLogging()) {
+		logger::info("Built remapped race list for [{:08X}] ({} -> {} races) for head parts flipped to {}",
+			a_sourceList->formID, a_sourceList->forms.size(), list->forms.size(), a_toFemale ? "female" : "male");
+	}
+	return list;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "RE/Skyrim.h"
+#include "Settings.h"
+#include <ClibUtil/singleton.hpp>
+
+// Rewrites the valid races of flipped head parts using the [RaceRemapToMale] and [RaceRemapToFemale] rules
+// Each transformed list is built once per (source list, direction) and shared by every head part using it
+// Built lists get a FormID in the plugin of the first head part using them and join the data handler like the head parts
+class RaceRemapper : public clib_util::singleton::ISingleton<RaceRemapper>
+{
+public:
+	// Resolve the races in the remapping rules, given as EditorIDs or as Plugin.esp|0x123; unknown races are logged and skipped
+	// Only the first call does anything, as the rules can't change while the game runs
+	void Build(const Settings& a_settings);
+
+	// Get the valid races for a head part flipped to the given gender
+	// Returns the source list itself if no rule touches any of its races
+	// A list built here is placed in the target file once RegisterLists is called
+	RE::BGSListForm* GetValidRaces(RE::BGSListForm* a_sourceList, bool a_toFemale, const RE::TESFile* a_targetFile);
+
+	// Give each list built since the last call a FormID and add it to the data handler
+	// Call once the pass's head parts are registered, so lists never take the FormIDs planned for them
+	void RegisterLists(const Settings& a_settings);
+
+	// Number of transformed lists built
+	std::size_t GetListCount() const { return _listCount; }
+
+private:
+	struct Key
+	{
+		const RE::BGSListForm* list;
+		bool toFemale;
+
+		bool operator==(const Key&) const = default;
+	};
+
+	struct KeyHash
+	{
+		std::size_t operator()(const Key& a_key) const noexcept
+		{
+			return std::hash<const void*>{}(a_key.list) ^ static_cast<std::size_t>(a_key.toFemale);
+		}
+	};
+
+	// A built list waiting for its FormID
+	struct PendingList
+	{
+		RE::BGSListForm* list;
+		const RE::BGSListForm* sourceList;
+		bool toFemale;
+		const RE::TESFile* targetFile;
+	};
+
+	// Find a race by EditorID or by Plugin.esp|0x123, or return nullptr
+	static RE::TESRace* FindRace(RE::TESDataHandler& a_dataHandler, std::string_view a_race);
+
+	// Build the transformed copy of a list, or return nullptr if no rule applies to it
+	RE::BGSListForm* BuildList(const RE::BGSListForm* a_sourceList, bool a_toFemale) const;
+
+	// Source race -> replacement races, per direction (to male, to female)
+	std::array<std::unordered_map<const RE::TESRace*, std::vector<RE::TESRace*>>, 2> _remaps;
+	std::unordered_map<Key, RE::BGSListForm*, KeyHash> _lists;  // nullptr if the source list is used as is
+	std::vector<PendingList> _pendingLists;
+	std::size_t _listCount = 0;
+	bool _built = false;
+};
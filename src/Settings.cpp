@@ -1,245 +1,412 @@
 #include "Settings.h"
+#include "Hash.h"
 #include "PCH.h"
 
 namespace
 {
 	constexpr bool INI_DEBUG_LOGGING = false;
-}
 
-void Settings::Load()
-{
-	CSimpleIniA ini;
-	ini.SetUnicode();
+	// INI names for FormIDUtils::HashMode values
+	constexpr std::array HASH_MODE_NAMES = { "Legacy"sv, "Stable"sv, "Migrate"sv };
 
-	const auto iniPath = fmt::format("Data/SKSE/Plugins/{}.ini", Version::PROJECT);
-	logger::info("Loading settings from {}", iniPath);
+	// INI names for Settings::LogOverflowPolicy values
+	constexpr std::array LOG_OVERFLOW_POLICY_NAMES = { "Block"sv, "DropOldest"sv };
 
-	bool needsUpdate = false;
-	bool hasOldKeys = false;
+	// Bounds for the async log queue
+	constexpr std::uint32_t MIN_LOG_QUEUE_SIZE = 128;
+	constexpr std::uint32_t MAX_LOG_QUEUE_SIZE = 1 << 20;
 
-	// Set default values - hair enabled by default, others disabled
-	_enabledTypes[RE::BGSHeadPart::HeadPartType::kHair] = { true, true };
-	_enabledTypes[RE::BGSHeadPart::HeadPartType::kScar] = { false, false };
-	_enabledTypes[RE::BGSHeadPart::HeadPartType::kEyebrows] = { false, false };
-	_enabledTypes[RE::BGSHeadPart::HeadPartType::kFacialHair] = { false, false };
-	_verboseLogging = false;
-	_showOnlyUnisexy = false;
-
-	if (ini.LoadFile(iniPath.c_str()) >= SI_OK) {
-		if constexpr (INI_DEBUG_LOGGING) {
-			logger::info("INI file loaded successfully. Dumping contents:");
-			CSimpleIniA::TNamesDepend sections;
-			ini.GetAllSections(sections);
-			for (const auto& section : sections) {
-				logger::info("Section: {}", section.pItem);
-				CSimpleIniA::TNamesDepend keys;
-				ini.GetAllKeys(section.pItem, keys);
-				for (const auto& key : keys) {
-					logger::info("  Key: {} = {}", key.pItem, ini.GetValue(section.pItem, key.pItem, ""));
-				}
+	// Parse an enum value from its INI name, case-insensitively
+	std::optional<std::uint32_t> ParseEnumValue(std::span<const std::string_view> a_names, std::string_view a_value)
+	{
+		for (std::size_t i = 0; i < a_names.size(); ++i) {
+			if (string::iequals(a_value, a_names[i])) {
+				return static_cast<std::uint32_t>(i);
 			}
 		}
+		return std::nullopt;
+	}
 
-		// Check for legacy keys that need migration
-		hasOldKeys = ini.KeyExists("HeadPartTypes", "Hair") ||
-		             ini.KeyExists("HeadPartTypes", "Scars") ||
-		             ini.KeyExists("HeadPartTypes", "Brows") ||
-		             ini.KeyExists("HeadPartTypes", "FacialHair") ||
-		             ini.KeyExists("Debug", "DisableVanillaParts");
-
-		// Check if new format keys are missing
-		const bool missingNewKeys = !ini.KeyExists("HeadPartTypes", "HairMale") ||
-		                            !ini.KeyExists("HeadPartTypes", "ScarsMale") ||
-		                            !ini.KeyExists("HeadPartTypes", "BrowsMale") ||
-		                            !ini.KeyExists("HeadPartTypes", "FacialHairMale") ||
-		                            !ini.KeyExists("HeadPartTypes", "HairFemale") ||
-		                            !ini.KeyExists("HeadPartTypes", "ScarsFemale") ||
-		                            !ini.KeyExists("HeadPartTypes", "BrowsFemale") ||
-		                            !ini.KeyExists("HeadPartTypes", "FacialHairFemale") ||
-		                            !ini.KeyExists("Debug", "VerboseLogging") ||
-		                            !ini.KeyExists("Debug", "ShowOnlyUnisexy");
-
-		needsUpdate = hasOldKeys || missingNewKeys;
-
-		// Load values from INI, preserving existing defaults
-		const char* section = "HeadPartTypes";
-		bool foundValue = false;
-
-		// Migrate legacy keys to new format
-		if (hasOldKeys) {
-			if constexpr (INI_DEBUG_LOGGING) {
-				logger::info("Migrating legacy keys to new format:");
+	// Replace a file with new contents unless it already holds exactly those bytes
+	// Writes a temporary file next to it and renames it over the original, so readers never see a partial file
+	void WriteFileIfChanged(const std::string& a_path, const std::string& a_contents)
+	{
+		std::error_code ec;
+		if (std::filesystem::file_size(a_path, ec) == a_contents.size() && !ec) {
+			std::ifstream existing(a_path, std::ios::binary);
+			std::string existingContents(a_contents.size(), '\0');
+			if (existing.read(existingContents.data(), static_cast<std::streamsize>(existingContents.size())) && existingContents == a_contents) {
+				logger::info("Settings file '{}' is already up to date", a_path);
+				return;
 			}
+		}
 
-			// Migrate each legacy key to both male and female variants
-			if (ini.KeyExists(section, "Hair")) {
-				const bool value = ini.GetBoolValue(section, "Hair", true, &foundValue);
-				_enabledTypes[RE::BGSHeadPart::HeadPartType::kHair] = { value, value };
-				if constexpr (INI_DEBUG_LOGGING) {
-					logger::info("  Migrated Hair={} to HairMale={}, HairFemale={}", value, value, value);
-				}
+		const auto tempPath = a_path + ".tmp";
+		{
+			std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+			if (!file.write(a_contents.data(), static_cast<std::streamsize>(a_contents.size())) || !file.flush()) {
+				logger::error("Failed to save settings file '{}'. Check file permissions.", a_path);
+				file.close();
+				std::filesystem::remove(tempPath, ec);
+				return;
 			}
+		}
 
-			if (ini.KeyExists(section, "Scars")) {
-				const bool value = ini.GetBoolValue(section, "Scars", false, &foundValue);
-				_enabledTypes[RE::BGSHeadPart::HeadPartType::kScar] = { value, value };
-				if constexpr (INI_DEBUG_LOGGING) {
-					logger::info("  Migrated Scars={} to ScarsMale={}, ScarsFemale={}", value, value, value);
-				}
-			}
+		std::filesystem::rename(tempPath, a_path, ec);
+		if (ec) {
+			logger::error("Failed to replace settings file '{}': {}", a_path, ec.message());
+			std::filesystem::remove(tempPath, ec);
+			return;
+		}
+		logger::info("Successfully saved settings file '{}'", a_path);
+	}
 
-			if (ini.KeyExists(section, "Brows")) {
-				const bool value = ini.GetBoolValue(section, "Brows", false, &foundValue);
-				_enabledTypes[RE::BGSHeadPart::HeadPartType::kEyebrows] = { value, value };
-				if constexpr (INI_DEBUG_LOGGING) {
-					logger::info("  Migrated Brows={} to BrowsMale={}, BrowsFemale={}", value, value, value);
-				}
+	// INI sections holding race remapping rules, indexed by flip direction
+	constexpr std::array RACE_REMAP_SECTIONS = { "RaceRemapToMale", "RaceRemapToFemale" };
+
+	// Split a comma-separated list, trimming whitespace and dropping empty entries
+	std::vector<std::string> SplitList(std::string_view a_list)
+	{
+		std::vector<std::string> entries;
+		while (!a_list.empty()) {
+			const auto comma = a_list.find(',');
+			auto entry = a_list.substr(0, comma);
+			a_list = comma == std::string_view::npos ? std::string_view{} : a_list.substr(comma + 1);
+
+			const auto first = entry.find_first_not_of(" \t");
+			if (first == std::string_view::npos) {
+				continue;
 			}
+			entry = entry.substr(first, entry.find_last_not_of(" \t") - first + 1);
+			entries.emplace_back(entry);
+		}
+		return entries;
+	}
 
-			if (ini.KeyExists(section, "FacialHair")) {
-				const bool value = ini.GetBoolValue(section, "FacialHair", false, &foundValue);
-				_enabledTypes[RE::BGSHeadPart::HeadPartType::kFacialHair] = { value, value };
-				if constexpr (INI_DEBUG_LOGGING) {
-					logger::info("  Migrated FacialHair={} to FacialHairMale={}, FacialHairFemale={}", value, value, value);
+	// Parse a boolean the way CSimpleIni's GetBoolValue does
+	std::optional<bool> ParseBool(std::string_view a_value)
+	{
+		if (a_value.empty()) {
+			return std::nullopt;
+		}
+		switch (a_value[0]) {
+		case 't':
+		case 'T':
+		case 'y':
+		case 'Y':
+		case '1':
+			return true;
+		case 'f':
+		case 'F':
+		case 'n':
+		case 'N':
+		case '0':
+			return false;
+		case 'o':
+		case 'O':
+			if (a_value.size() > 1) {
+				if (a_value[1] == 'n' || a_value[1] == 'N') {
+					return true;
 				}
-			}
-
-			if (ini.KeyExists("Debug", "DisableVanillaParts")) {
-				const bool value = ini.GetBoolValue("Debug", "DisableVanillaParts", false, &foundValue);
-				_showOnlyUnisexy = value;
-				if constexpr (INI_DEBUG_LOGGING) {
-					logger::info("  Migrated DisableVanillaParts={} to ShowOnlyUnisexy={}", value, value);
+				if (a_value[1] == 'f' || a_value[1] == 'F') {
+					return false;
 				}
 			}
+			return std::nullopt;
+		default:
+			return std::nullopt;
 		}
+	}
+}
 
-		// Load current format keys (these override any migrated values)
-		if (ini.KeyExists(section, "HairMale")) {
-			_enabledTypes[RE::BGSHeadPart::HeadPartType::kHair].maleEnabled =
-				ini.GetBoolValue(section, "HairMale", true, &foundValue);
-			if constexpr (INI_DEBUG_LOGGING) {
-				if (foundValue) {
-					logger::info("  Loaded HairMale={}", _enabledTypes[RE::BGSHeadPart::HeadPartType::kHair].maleEnabled);
-				}
-			}
-		}
+template <auto Member>
+std::uint32_t Settings::GetMember(const Settings& a_settings)
+{
+	return static_cast<std::uint32_t>(a_settings.*Member);
+}
 
-		if (ini.KeyExists(section, "HairFemale")) {
-			_enabledTypes[RE::BGSHeadPart::HeadPartType::kHair].femaleEnabled =
-				ini.GetBoolValue(section, "HairFemale", true, &foundValue);
-			if constexpr (INI_DEBUG_LOGGING) {
-				if (foundValue) {
-					logger::info("  Loaded HairFemale={}", _enabledTypes[RE::BGSHeadPart::HeadPartType::kHair].femaleEnabled);
-				}
-			}
-		}
+template <auto Member>
+void Settings::SetMember(Settings& a_settings, std::uint32_t a_value)
+{
+	using T = std::remove_cvref_t<decltype(a_settings.*Member)>;
+	if constexpr (std::is_same_v<T, bool>) {
+		a_settings.*Member = a_value != 0;
+	} else {
+		a_settings.*Member = static_cast<T>(a_value);
+	}
+}
 
-		if (ini.KeyExists(section, "ScarsMale")) {
-			_enabledTypes[RE::BGSHeadPart::HeadPartType::kScar].maleEnabled =
-				ini.GetBoolValue(section, "ScarsMale", false, &foundValue);
-			if constexpr (INI_DEBUG_LOGGING) {
-				if (foundValue) {
-					logger::info("  Loaded ScarsMale={}", _enabledTypes[RE::BGSHeadPart::HeadPartType::kScar].maleEnabled);
-				}
-			}
-		}
+template <RE::BGSHeadPart::HeadPartType Type, bool Settings::GenderSettings::*Gender>
+std::uint32_t Settings::GetGender(const Settings& a_settings)
+{
+	return a_settings._enabledTypes[Type].*Gender;
+}
 
-		if (ini.KeyExists(section, "ScarsFemale")) {
-			_enabledTypes[RE::BGSHeadPart::HeadPartType::kScar].femaleEnabled =
-				ini.GetBoolValue(section, "ScarsFemale", false, &foundValue);
-			if constexpr (INI_DEBUG_LOGGING) {
-				if (foundValue) {
-					logger::info("  Loaded ScarsFemale={}", _enabledTypes[RE::BGSHeadPart::HeadPartType::kScar].femaleEnabled);
-				}
-			}
-		}
+template <RE::BGSHeadPart::HeadPartType Type, bool Settings::GenderSettings::*Gender>
+void Settings::SetGender(Settings& a_settings, std::uint32_t a_value)
+{
+	a_settings._enabledTypes[Type].*Gender = a_value != 0;
+}
 
-		if (ini.KeyExists(section, "BrowsMale")) {
-			_enabledTypes[RE::BGSHeadPart::HeadPartType::kEyebrows].maleEnabled =
-				ini.GetBoolValue(section, "BrowsMale", false, &foundValue);
-			if constexpr (INI_DEBUG_LOGGING) {
-				if (foundValue) {
-					logger::info("  Loaded BrowsMale={}", _enabledTypes[RE::BGSHeadPart::HeadPartType::kEyebrows].maleEnabled);
-				}
+std::span<const Settings::KeyDescriptor> Settings::GetKeyDescriptors()
+{
+	using Type = RE::BGSHeadPart::HeadPartType;
+	constexpr auto male = &GenderSettings::maleEnabled;
+	constexpr auto female = &GenderSettings::femaleEnabled;
+
+	// Rows are written in this order, so keep each section's keys together
+	static constexpr std::array KEYS = {
+		// HeadPartTypes section - organize by conversion direction
+		KeyDescriptor{ .section = "HeadPartTypes", .key = "HairMale", .type = ValueType::kBool, .defaultValue = true,
+			.get = GetGender<Type::kHair, male>, .set = SetGender<Type::kHair, male>, .legacyKey = "Hair",
+			.comment = "\n; Enable converting female parts to male" },
+		KeyDescriptor{ .section = "HeadPartTypes", .key = "ScarsMale", .type = ValueType::kBool, .defaultValue = false,
+			.get = GetGender<Type::kScar, male>, .set = SetGender<Type::kScar, male>, .legacyKey = "Scars" },
+		KeyDescriptor{ .section = "HeadPartTypes", .key = "BrowsMale", .type = ValueType::kBool, .defaultValue = false,
+			.get = GetGender<Type::kEyebrows, male>, .set = SetGender<Type::kEyebrows, male>, .legacyKey = "Brows" },
+		KeyDescriptor{ .section = "HeadPartTypes", .key = "FacialHairMale", .type = ValueType::kBool, .defaultValue = false,
+			.get = GetGender<Type::kFacialHair, male>, .set = SetGender<Type::kFacialHair, male>, .legacyKey = "FacialHair" },
+		KeyDescriptor{ .section = "HeadPartTypes", .key = "HairFemale", .type = ValueType::kBool, .defaultValue = true,
+			.get = GetGender<Type::kHair, female>, .set = SetGender<Type::kHair, female>, .legacyKey = "Hair",
+			.comment = "\n; Enable converting male parts to female" },
+		KeyDescriptor{ .section = "HeadPartTypes", .key = "ScarsFemale", .type = ValueType::kBool, .defaultValue = false,
+			.get = GetGender<Type::kScar, female>, .set = SetGender<Type::kScar, female>, .legacyKey = "Scars" },
+		KeyDescriptor{ .section = "HeadPartTypes", .key = "BrowsFemale", .type = ValueType::kBool, .defaultValue = false,
+			.get = GetGender<Type::kEyebrows, female>, .set = SetGender<Type::kEyebrows, female>, .legacyKey = "Brows" },
+		KeyDescriptor{ .section = "HeadPartTypes", .key = "FacialHairFemale", .type = ValueType::kBool, .defaultValue = false,
+			.get = GetGender<Type::kFacialHair, female>, .set = SetGender<Type::kFacialHair, female>, .legacyKey = "FacialHair" },
+
+		// Debug section
+		KeyDescriptor{ .section = "Debug", .key = "VerboseLogging", .type = ValueType::kBool, .defaultValue = false,
+			.get = GetMember<&Settings::_verboseLogging>, .set = SetMember<&Settings::_verboseLogging>,
+			.comment = "\n; Enable detailed logging for debugging" },
+		KeyDescriptor{ .section = "Debug", .key = "AsyncLogging", .type = ValueType::kBool, .defaultValue = false,
+			.get = GetMember<&Settings::_asyncLogging>, .set = SetMember<&Settings::_asyncLogging>,
+			.comment = "\n; Write log messages on a background thread so verbose logging doesn't slow down loading",
+			.restartRequired = true },
+		KeyDescriptor{ .section = "Debug", .key = "LogQueueSize", .type = ValueType::kUInt, .defaultValue = 8192,
+			.get = GetMember<&Settings::_logQueueSize>, .set = SetMember<&Settings::_logQueueSize>,
+			.comment = "; Number of messages the background logger can queue",
+			.minValue = MIN_LOG_QUEUE_SIZE, .maxValue = MAX_LOG_QUEUE_SIZE,
+			.restartRequired = true },
+		KeyDescriptor{ .section = "Debug", .key = "LogOverflowPolicy", .type = ValueType::kEnum, .defaultValue = std::to_underlying(LogOverflowPolicy::kBlock),
+			.get = GetMember<&Settings::_logOverflowPolicy>, .set = SetMember<&Settings::_logOverflowPolicy>,
+			.comment = "; What to do when the queue is full\n"
+				"; Block: wait for the queue to drain, nothing is lost\n"
+				"; DropOldest: discard the oldest queued messages",
+			.enumNames = LOG_OVERFLOW_POLICY_NAMES,
+			.restartRequired = true },
+		KeyDescriptor{ .section = "Debug", .key = "GenerationReport", .type = ValueType::kBool, .defaultValue = false,
+			.get = GetMember<&Settings::_generationReport>, .set = SetMember<&Settings::_generationReport>,
+			.comment = "\n; Write a JSON Lines report of every generated head part next to the log" },
+		KeyDescriptor{ .section = "Debug", .key = "ShowOnlyUnisexy", .type = ValueType::kBool, .defaultValue = false,
+			.get = GetMember<&Settings::_showOnlyUnisexy>, .set = SetMember<&Settings::_showOnlyUnisexy>, .legacyKey = "DisableVanillaParts",
+			.comment = "\n; Disable original vanilla head parts after creating gender-flipped versions" },
+		KeyDescriptor{ .section = "Debug", .key = "HotReload", .type = ValueType::kBool, .defaultValue = false,
+			.get = GetMember<&Settings::_hotReload>, .set = SetMember<&Settings::_hotReload>,
+			.comment = "\n; Reapply this file when it changes, checked when the race menu opens and when a save is loaded\n"
+				"; Type and gender toggles and ShowOnlyUnisexy take effect without restarting the game" },
+
+		// Performance section
+		KeyDescriptor{ .section = "Performance", .key = "GenerationCache", .type = ValueType::kBool, .defaultValue = true,
+			.get = GetMember<&Settings::_generationCache>, .set = SetMember<&Settings::_generationCache>,
+			.comment = "\n; Reuse the head parts generated on the previous launch while the load order and settings are unchanged",
+			.restartRequired = true },
+
+		// FormIDs section
+		KeyDescriptor{ .section = "FormIDs", .key = "HashMode", .type = ValueType::kEnum, .defaultValue = std::to_underlying(FormIDUtils::HashMode::kLegacy),
+			.get = GetMember<&Settings::_formIDHashMode>, .set = SetMember<&Settings::_formIDHashMode>,
+			.comment = "\n; How FormIDs are derived from EditorIDs\n"
+				"; Legacy: the derivation older builds used, so existing saves keep working\n"
+				"; Stable: identical in every build; changes every FormID, so saves referencing Unisexy parts lose them\n"
+				"; Migrate: Stable, and the FormID an older build assigned is registered as a second FormID of each part\n"
+				";   Older FormIDs only resolve if the load order and enabled settings match the build that assigned them",
+			.enumNames = HASH_MODE_NAMES,
+			.restartRequired = true },
+	};
+	static_assert(KEYS.size() <= MAX_KEY_COUNT);
+	return KEYS;
+}
+
+void Settings::ParseValue(const KeyDescriptor& a_descriptor, std::string_view a_value)
+{
+	std::optional<std::uint32_t> value;
+	switch (a_descriptor.type) {
+	case ValueType::kBool:
+		if (const auto parsed = ParseBool(a_value)) {
+			value = *parsed;
+		}
+		break;
+	case ValueType::kUInt:
+		{
+			// Wide enough for every uint32 and negative input; long is only 32 bits on MSVC
+			std::int64_t parsed = 0;
+			const auto [ptr, ec] = std::from_chars(a_value.data(), a_value.data() + a_value.size(), parsed);
+			if (ec == std::errc{}) {
+				value = static_cast<std::uint32_t>(std::clamp<std::int64_t>(parsed, a_descriptor.minValue, a_descriptor.maxValue));
 			}
 		}
+		break;
+	case ValueType::kEnum:
+		value = ParseEnumValue(a_descriptor.enumNames, a_value);
+		break;
+	}
 
-		if (ini.KeyExists(section, "BrowsFemale")) {
-			_enabledTypes[RE::BGSHeadPart::HeadPartType::kEyebrows].femaleEnabled =
-				ini.GetBoolValue(section, "BrowsFemale", false, &foundValue);
-			if constexpr (INI_DEBUG_LOGGING) {
-				if (foundValue) {
-					logger::info("  Loaded BrowsFemale={}", _enabledTypes[RE::BGSHeadPart::HeadPartType::kEyebrows].femaleEnabled);
-				}
+	if (!value) {
+		logger::warn("Invalid {} '{}', using {}", a_descriptor.key, a_value, FormatValue(a_descriptor, a_descriptor.get(*this)));
+		return;
+	}
+
+	a_descriptor.set(*this, *value);
+	if constexpr (INI_DEBUG_LOGGING) {
+		logger::info("  Loaded {}={}", a_descriptor.key, FormatValue(a_descriptor, *value));
+	}
+}
+
+std::string Settings::FormatValue(const KeyDescriptor& a_descriptor, std::uint32_t a_value)
+{
+	switch (a_descriptor.type) {
+	case ValueType::kBool:
+		return a_value ? "true" : "false";
+	case ValueType::kEnum:
+		return a_value < a_descriptor.enumNames.size() ? std::string(a_descriptor.enumNames[a_value]) : std::string();
+	default:
+		return std::to_string(a_value);
+	}
+}
+
+void Settings::Load(bool a_reload)
+{
+	CSimpleIniA ini;
+	ini.SetUnicode();
+	ini.SetMultiKey(true);  // [Rules] keys may be repeated
+
+	const auto iniPath = GetIniPath();
+	logger::info("Loading settings from {}", iniPath);
+
+	bool needsUpdate = false;
+
+	// Set default values - hair enabled by default, others disabled
+	const auto keys = GetKeyDescriptors();
+	std::array<std::uint32_t, MAX_KEY_COUNT> startupValues{};
+	for (std::size_t i = 0; i < keys.size(); ++i) {
+		startupValues[i] = keys[i].get(*this);
+	}
+	auto startupRules = std::move(_rules);
+	auto startupRaceRemaps = std::move(_raceRemaps);
+	_rules = {};
+	_raceRemaps = {};
+	_enabledTypes = {};
+	for (const auto& descriptor : keys) {
+		descriptor.set(*this, descriptor.defaultValue);
+	}
+
+	if (ini.LoadFile(iniPath.c_str()) >= SI_OK) {
+		// Keys loaded from their current name; legacy keys never override these, wherever they appear
+		std::bitset<MAX_KEY_COUNT> loadedKeys;
+		bool hasOldKeys = false;
+
+		// Walk every parsed key once and dispatch it through the key table
+		CSimpleIniA::TNamesDepend sections;
+		ini.GetAllSections(sections);
+		for (const auto& section : sections) {
+			const auto* sectionKeys = ini.GetSection(section.pItem);
+			if (!sectionKeys) {
+				continue;
 			}
-		}
 
-		if (ini.KeyExists(section, "FacialHairMale")) {
-			_enabledTypes[RE::BGSHeadPart::HeadPartType::kFacialHair].maleEnabled =
-				ini.GetBoolValue(section, "FacialHairMale", false, &foundValue);
-			if constexpr (INI_DEBUG_LOGGING) {
-				if (foundValue) {
-					logger::info("  Loaded FacialHairMale={}", _enabledTypes[RE::BGSHeadPart::HeadPartType::kFacialHair].maleEnabled);
+			const bool isRulesSection = string::iequals(section.pItem, "Rules"sv);
+			const auto raceRemapSection = std::ranges::find_if(RACE_REMAP_SECTIONS, [&](const char* a_name) { return string::iequals(section.pItem, a_name); });
+			for (const auto& [key, value] : *sectionKeys) {
+				if constexpr (INI_DEBUG_LOGGING) {
+					logger::info("  [{}] {} = {}", section.pItem, key.pItem, value);
 				}
-			}
-		}
 
-		if (ini.KeyExists(section, "FacialHairFemale")) {
-			_enabledTypes[RE::BGSHeadPart::HeadPartType::kFacialHair].femaleEnabled =
-				ini.GetBoolValue(section, "FacialHairFemale", false, &foundValue);
-			if constexpr (INI_DEBUG_LOGGING) {
-				if (foundValue) {
-					logger::info("  Loaded FacialHairFemale={}", _enabledTypes[RE::BGSHeadPart::HeadPartType::kFacialHair].femaleEnabled);
+				// Rule keys repeat, one pattern each
+				if (isRulesSection) {
+					const auto it = std::ranges::find_if(HeadPartRules::KEY_NAMES, [&](std::string_view a_name) { return string::iequals(key.pItem, a_name); });
+					if (it != HeadPartRules::KEY_NAMES.end()) {
+						_rules.Add(static_cast<HeadPartRules::Kind>(std::distance(HeadPartRules::KEY_NAMES.begin(), it)), value);
+					} else {
+						logger::warn("Unknown rule '{}'", key.pItem);
+					}
+					continue;
 				}
-			}
-		}
 
-		if (ini.KeyExists("Debug", "VerboseLogging")) {
-			_verboseLogging = ini.GetBoolValue("Debug", "VerboseLogging", false, &foundValue);
-			if constexpr (INI_DEBUG_LOGGING) {
-				if (foundValue) {
-					logger::info("  Loaded VerboseLogging={}", _verboseLogging);
+				// Race remapping keys are races, by EditorID or Plugin.esp|0x123
+				if (raceRemapSection != RACE_REMAP_SECTIONS.end()) {
+					_raceRemaps[std::distance(RACE_REMAP_SECTIONS.begin(), raceRemapSection)].emplace_back(key.pItem, SplitList(value));
+					continue;
 				}
-			}
-		}
 
-		if (ini.KeyExists("Debug", "ShowOnlyUnisexy")) {
-			_showOnlyUnisexy = ini.GetBoolValue("Debug", "ShowOnlyUnisexy", false, &foundValue);
-			if constexpr (INI_DEBUG_LOGGING) {
-				if (foundValue) {
-					logger::info("  Loaded ShowOnlyUnisexy={}", _showOnlyUnisexy);
+				for (std::size_t i = 0; i < keys.size(); ++i) {
+					const auto& descriptor = keys[i];
+					if (!string::iequals(section.pItem, descriptor.section)) {
+						continue;
+					}
+
+					if (string::iequals(key.pItem, descriptor.key)) {
+						// Current format keys override any migrated values
+						ParseValue(descriptor, value);
+						loadedKeys.set(i);
+					} else if (descriptor.legacyKey && string::iequals(key.pItem, descriptor.legacyKey)) {
+						// Migrate legacy keys to every key that replaced them
+						hasOldKeys = true;
+						if (!loadedKeys.test(i)) {
+							ParseValue(descriptor, value);
+						}
+					}
 				}
 			}
 		}
 
+		// Rewrite the file if any legacy key is present or any current key is missing
+		const bool missingNewKeys = loadedKeys.count() != keys.size();
+		needsUpdate = hasOldKeys || missingNewKeys;
+
 		if constexpr (INI_DEBUG_LOGGING) {
 			logger::info("Final loaded settings:");
-			logger::info("  Hair: Male={}, Female={}",
-				_enabledTypes[RE::BGSHeadPart::HeadPartType::kHair].maleEnabled,
-				_enabledTypes[RE::BGSHeadPart::HeadPartType::kHair].femaleEnabled);
-			logger::info("  Scars: Male={}, Female={}",
-				_enabledTypes[RE::BGSHeadPart::HeadPartType::kScar].maleEnabled,
-				_enabledTypes[RE::BGSHeadPart::HeadPartType::kScar].femaleEnabled);
-			logger::info("  Brows: Male={}, Female={}",
-				_enabledTypes[RE::BGSHeadPart::HeadPartType::kEyebrows].maleEnabled,
-				_enabledTypes[RE::BGSHeadPart::HeadPartType::kEyebrows].femaleEnabled);
-			logger::info("  FacialHair: Male={}, Female={}",
-				_enabledTypes[RE::BGSHeadPart::HeadPartType::kFacialHair].maleEnabled,
-				_enabledTypes[RE::BGSHeadPart::HeadPartType::kFacialHair].femaleEnabled);
-			logger::info("  Debug: VerboseLogging={}, ShowOnlyUnisexy={}",
-				_verboseLogging, _showOnlyUnisexy);
+			for (const auto& descriptor : keys) {
+				logger::info("  {}: {}={}", descriptor.section, descriptor.key, FormatValue(descriptor, descriptor.get(*this)));
+			}
+			for (std::uint32_t kind = 0; kind < std::to_underlying(HeadPartRules::Kind::kTotal); ++kind) {
+				for (const auto& pattern : _rules.GetPatterns(static_cast<HeadPartRules::Kind>(kind))) {
+					logger::info("  Rules: {}={}", HeadPartRules::KEY_NAMES[kind], pattern);
+				}
+			}
 		}
 	} else {
 		logger::error("Failed to load INI file '{}'. Creating new file with defaults.", iniPath);
 		needsUpdate = true;
 	}
 
+	BuildClassifyTable();
+
 	// Create or update INI file if needed
 	if (needsUpdate) {
 		SaveConfigFile(ini, iniPath);
 	} else {
 		logger::info("Settings loaded successfully. No update needed.");
 	}
+
+	// Keep the values the running game was started with; the file keeps the edited ones
+	if (a_reload) {
+		for (std::size_t i = 0; i < keys.size(); ++i) {
+			const auto& descriptor = keys[i];
+			if (descriptor.restartRequired && descriptor.get(*this) != startupValues[i]) {
+				logger::info("{} changes take effect after restarting the game", descriptor.key);
+				descriptor.set(*this, startupValues[i]);
+			}
+		}
+		if (_rules != startupRules) {
+			logger::info("Rules changes take effect after restarting the game");
+			_rules = std::move(startupRules);
+		}
+		if (_raceRemaps != startupRaceRemaps) {
+			logger::info("Race remapping changes take effect after restarting the game");
+			_raceRemaps = std::move(startupRaceRemaps);
+		}
+	}
 }
 
 void Settings::SaveConfigFile(CSimpleIniA& ini, const std::string& iniPath)
@@ -252,58 +419,91 @@ void Settings::SaveConfigFile(CSimpleIniA& ini, const std::string& iniPath)
 		"; This mod creates gender-flipped versions of head parts (hair, facial hair, scars, eyebrows).\n"
 		"; Set each option to true/false to enable/disable creating gender-flipped versions.");
 
-	// HeadPartTypes section - organize by conversion direction
-	ini.SetValue("HeadPartTypes", "HairMale",
-		_enabledTypes[RE::BGSHeadPart::HeadPartType::kHair].maleEnabled ? "true" : "false",
-		"\n; Enable converting female parts to male versions");
-	ini.SetValue("HeadPartTypes", "ScarsMale",
-		_enabledTypes[RE::BGSHeadPart::HeadPartType::kScar].maleEnabled ? "true" : "false");
-	ini.SetValue("HeadPartTypes", "BrowsMale",
-		_enabledTypes[RE::BGSHeadPart::HeadPartType::kEyebrows].maleEnabled ? "true" : "false");
-	ini.SetValue("HeadPartTypes", "FacialHairMale",
-		_enabledTypes[RE::BGSHeadPart::HeadPartType::kFacialHair].maleEnabled ? "true" : "false");
-
-	ini.SetValue("HeadPartTypes", "HairFemale",
-		_enabledTypes[RE::BGSHeadPart::HeadPartType::kHair].femaleEnabled ? "true" : "false",
-		"\n; Enable converting male parts to female versions");
-	ini.SetValue("HeadPartTypes", "ScarsFemale",
-		_enabledTypes[RE::BGSHeadPart::HeadPartType::kScar].femaleEnabled ? "true" : "false");
-	ini.SetValue("HeadPartTypes", "BrowsFemale",
-		_enabledTypes[RE::BGSHeadPart::HeadPartType::kEyebrows].femaleEnabled ? "true" : "false");
-	ini.SetValue("HeadPartTypes", "FacialHairFemale",
-		_enabledTypes[RE::BGSHeadPart::HeadPartType::kFacialHair].femaleEnabled ? "true" : "false");
-
-	// Debug section
-	ini.SetValue("Debug", "VerboseLogging", _verboseLogging ? "true" : "false",
-		"\n; Enable detailed logging for debugging");
-	ini.SetValue("Debug", "ShowOnlyUnisexy", _showOnlyUnisexy ? "true" : "false",
-		"\n; Hide vanilla head parts, showing only Unisexy-created versions");
-
-	// Clean up legacy keys that might still exist
-	ini.Delete("HeadPartTypes", "Hair");
-	ini.Delete("HeadPartTypes", "Scars");
-	ini.Delete("HeadPartTypes", "Brows");
-	ini.Delete("HeadPartTypes", "FacialHair");
-	ini.Delete("Debug", "DisableVanillaParts");
+	for (const auto& descriptor : GetKeyDescriptors()) {
+		ini.SetValue(descriptor.section, descriptor.key, FormatValue(descriptor, descriptor.get(*this)).c_str(), descriptor.comment);
+	}
 
+	// Rules section
+	ini.SetValue("Rules", nullptr, nullptr,
+		"\n; Limit which head parts are flipped; each key may be repeated\n"
+		"; Patterns are case-insensitive, * matches any run of characters and ? any one character\n"
+		"; IncludePlugin, IncludeEditorID: if any are given, only matching head parts are flipped\n"
+		"; ExcludePlugin, ExcludeEditorID: matching head parts are never flipped\n"
+		"; Plugins are matched against the plugin that defines the head part, e.g.\n"
+		"; IncludePlugin = KS Hairdos*.esp\n"
+		"; ExcludePlugin = *Vampire*");
+	for (std::uint32_t kind = 0; kind < std::to_underlying(HeadPartRules::Kind::kTotal); ++kind) {
+		for (const auto& pattern : _rules.GetPatterns(static_cast<HeadPartRules::Kind>(kind))) {
+			ini.SetValue("Rules", HeadPartRules::KEY_NAMES[kind].data(), pattern.c_str());
+		}
+	}
+
+	// Race remapping sections
+	for (std::size_t direction = 0; direction < RACE_REMAP_SECTIONS.size(); ++direction) {
+		const auto* sectionName = RACE_REMAP_SECTIONS[direction];
+		ini.SetValue(sectionName, nullptr, nullptr, direction == 0 ?
+			"\n; Replace races in the valid races of head parts flipped to male\n"
+			"; Each key is a race, the value is a comma-separated list of the races replacing it\n"
+			"; Races are given by EditorID, or by plugin and FormID as Plugin.esp|0x123\n"
+			"; An empty value removes the race, e.g.\n"
+			"; NordRace = NordRace, NordRaceVampire, MyRaces.esp|0x801" :
+			"\n; Replace races in the valid races of head parts flipped to female, as above");
+		for (const auto& [race, replacements] : _raceRemaps[direction]) {
+			std::string value;
+			for (const auto& replacement : replacements) {
+				if (!value.empty()) {
+					value += ", ";
+				}
+				value += replacement;
+			}
+			ini.SetValue(sectionName, race.c_str(), value.c_str());
+		}
+	}
+
+	std::string contents;
+	if (ini.Save(contents) < 0) {
+		logger::error("Failed to serialize settings for '{}'", iniPath);
+		return;
+	}
+
+	// Write off the load path; only one write is ever in flight
 	logger::info("Saving updated settings to {}", iniPath);
-	if (ini.SaveFile(iniPath.c_str()) < 0) {
-		logger::error("Failed to save settings file '{}'. Check file permissions.", iniPath);
-	} else {
-		logger::info("Successfully saved settings file '{}'", iniPath);
+	WaitForPendingSave();
+	_pendingSave = std::jthread([iniPath, contents = std::move(contents)] {
+		WriteFileIfChanged(iniPath, contents);
+	});
+}
+
+void Settings::WaitForPendingSave()
+{
+	if (_pendingSave.joinable()) {
+		_pendingSave.join();
 	}
 }
 
+void Settings::BuildClassifyTable()
+{
+	_classifier.Build(_enabledTypes.entries);
+}
+
+Settings::Classification Settings::Classify(RE::BGSHeadPart::HeadPartType a_type, HeadPartFlags a_flags) const
+{
+	return _classifier.Classify(static_cast<HeadPartType>(std::to_underlying(a_type)), a_flags.underlying());
+}
+
+const HeadPartClassifier& Settings::GetClassifier() const
+{
+	return _classifier;
+}
+
 bool Settings::IsMaleEnabled(RE::BGSHeadPart::HeadPartType a_type) const
 {
-	const auto it = _enabledTypes.find(a_type);
-	return it != _enabledTypes.end() && it->second.maleEnabled;
+	return std::to_underlying(a_type) < HEAD_PART_TYPE_COUNT && _enabledTypes[a_type].maleEnabled;
 }
 
 bool Settings::IsFemaleEnabled(RE::BGSHeadPart::HeadPartType a_type) const
 {
-	const auto it = _enabledTypes.find(a_type);
-	return it != _enabledTypes.end() && it->second.femaleEnabled;
+	return std::to_underlying(a_type) < HEAD_PART_TYPE_COUNT && _enabledTypes[a_type].femaleEnabled;
 }
 
 bool Settings::IsVerboseLogging() const
@@ -311,25 +511,80 @@ bool Settings::IsVerboseLogging() const
 	return _verboseLogging;
 }
 
+bool Settings::IsAsyncLogging() const
+{
+	return _asyncLogging;
+}
+
+std::uint32_t Settings::GetLogQueueSize() const
+{
+	return _logQueueSize;
+}
+
+Settings::LogOverflowPolicy Settings::GetLogOverflowPolicy() const
+{
+	return _logOverflowPolicy;
+}
+
+bool Settings::IsGenerationReportEnabled() const
+{
+	return _generationReport;
+}
+
 bool Settings::IsShowOnlyUnisexy() const
 {
 	return _showOnlyUnisexy;
 }
 
-std::string Settings::GetHeadPartTypeName(RE::BGSHeadPart::HeadPartType type)
+bool Settings::IsHotReload() const
 {
-	switch (type) {
-	case RE::BGSHeadPart::HeadPartType::kHair:
-		return "Hair";
-	case RE::BGSHeadPart::HeadPartType::kFacialHair:
-		return "FacialHair";
-	case RE::BGSHeadPart::HeadPartType::kScar:
-		return "Scars";
-	case RE::BGSHeadPart::HeadPartType::kEyebrows:
-		return "Brows";
-	case RE::BGSHeadPart::HeadPartType::kMisc:
-		return "Misc";
-	default:
-		return "Unknown";
+	return _hotReload;
+}
+
+const HeadPartRules& Settings::GetRules() const
+{
+	return _rules;
+}
+
+const Settings::RaceRemapRules& Settings::GetRaceRemap(bool a_toFemale) const
+{
+	return _raceRemaps[a_toFemale ? 1 : 0];
+}
+
+std::string Settings::GetIniPath()
+{
+	return fmt::format("Data/SKSE/Plugins/{}.ini", Version::PROJECT);
+}
+
+bool Settings::IsGenerationCacheEnabled() const
+{
+	return _generationCache;
+}
+
+FormIDUtils::HashMode Settings::GetFormIDHashMode() const
+{
+	return _formIDHashMode;
+}
+
+std::uint64_t Settings::GetHash() const
+{
+	Hash::Hasher hasher;
+	for (const auto& genderSettings : _enabledTypes.entries) {
+		hasher.Update(genderSettings.maleEnabled);
+		hasher.Update(genderSettings.femaleEnabled);
+	}
+	hasher.Update(_showOnlyUnisexy);
+	hasher.Update(_formIDHashMode);
+	_rules.AddToHash(hasher);
+	for (const auto& raceRemap : _raceRemaps) {
+		hasher.Update(static_cast<std::uint64_t>(raceRemap.size()));
+		for (const auto& [race, replacements] : raceRemap) {
+			hasher.Update(std::string_view(race));
+			hasher.Update(static_cast<std::uint64_t>(replacements.size()));
+			for (const auto& replacement : replacements) {
+				hasher.Update(std::string_view(replacement));
+			}
+		}
 	}
+	return hasher.Get();
 }
@@ -1,13 +1,39 @@
 #pragma once
 
+#include "FormIDUtils.h"
+#include "HeadPartClassifier.h"
+#include "HeadPartRules.h"
 #include "RE/B/BGSHeadPart.h"
 #include <ClibUtil/simpleIni.hpp>
 
 class Settings : public clib_util::singleton::ISingleton<Settings>
 {
 public:
+	using HeadPartFlags = decltype(RE::BGSHeadPart::flags);
+
+	// How the generation pass handles a head part
+	using Classification = HeadPartClassifier::Classification;
+
+	// What the async logger does when its queue is full
+	enum class LogOverflowPolicy : std::uint32_t
+	{
+		kBlock,       // Wait for the logging thread to catch up
+		kDropOldest,  // Overwrite the oldest queued message
+	};
+
 	// Load settings from INI file, handling legacy format migration
-	void Load();
+	// A reload keeps the startup value of settings that need a restart to change
+	void Load(bool a_reload = false);
+
+	// Wait for the INI rewrite started by Load, if any, to finish
+	void WaitForPendingSave();
+
+	// Classify a head part by type and flags with a single table lookup
+	// Returns the flip direction or the reason the part is skipped; never kNone, kNoEditorID or kExcludedByRule
+	Classification Classify(RE::BGSHeadPart::HeadPartType a_type, HeadPartFlags a_flags) const;
+
+	// Classification table built from the gender toggles
+	const HeadPartClassifier& GetClassifier() const;
 
 	// Check if male conversion is enabled for given head part type
 	bool IsMaleEnabled(RE::BGSHeadPart::HeadPartType a_type) const;
@@ -18,24 +44,127 @@ public:
 	// Check if verbose logging is enabled
 	bool IsVerboseLogging() const;
 
+	// Check if log messages should be written on a background thread
+	bool IsAsyncLogging() const;
+
+	// Get the number of messages the async logger can queue
+	std::uint32_t GetLogQueueSize() const;
+
+	// Get what the async logger does when its queue is full
+	LogOverflowPolicy GetLogOverflowPolicy() const;
+
+	// Check if a machine-readable generation report should be written
+	bool IsGenerationReportEnabled() const;
+
 	// Check if only Unisexy parts should be shown (vanilla parts hidden)
 	bool IsShowOnlyUnisexy() const;
 
-	// Get human-readable name for head part type
-	static std::string GetHeadPartTypeName(RE::BGSHeadPart::HeadPartType type);
+	// Check if changes to the INI should be applied while the game is running
+	bool IsHotReload() const;
+
+	// Get the plugin and EditorID include/exclude rules
+	const HeadPartRules& GetRules() const;
+
+	// Race remapping rules for one flip direction: race EditorID -> EditorIDs of the races replacing it
+	using RaceRemapRules = std::vector<std::pair<std::string, std::vector<std::string>>>;
+
+	// Get the race remapping rules applied to head parts flipped to the given gender
+	const RaceRemapRules& GetRaceRemap(bool a_toFemale) const;
+
+	// Check if the on-disk generation cache should be used
+	bool IsGenerationCacheEnabled() const;
+
+	// Get the hash used to derive FormIDs from EditorIDs
+	FormIDUtils::HashMode GetFormIDHashMode() const;
+
+	// Stable hash of every setting that affects which head parts are generated
+	std::uint64_t GetHash() const;
+
+	// Path of the INI file
+	static std::string GetIniPath();
 
 private:
 	// Gender-specific settings for each head part type
-	struct GenderSettings
+	using GenderSettings = HeadPartClassifier::TypeToggles;
+
+	static constexpr std::size_t HEAD_PART_TYPE_COUNT = HeadPartClassifier::TYPE_COUNT;
+
+	// Gender settings indexed directly by head part type
+	struct GenderTable
 	{
-		bool maleEnabled = false;    // Enable male conversion (female -> male)
-		bool femaleEnabled = false;  // Enable female conversion (male -> female)
+		GenderSettings& operator[](RE::BGSHeadPart::HeadPartType a_type) { return entries[std::to_underlying(a_type)]; }
+		const GenderSettings& operator[](RE::BGSHeadPart::HeadPartType a_type) const { return entries[std::to_underlying(a_type)]; }
+
+		std::array<GenderSettings, HEAD_PART_TYPE_COUNT> entries{};
 	};
 
-	// Save configuration to INI file
+	// How an INI value is parsed and written
+	enum class ValueType : std::uint8_t
+	{
+		kBool,
+		kUInt,  // Clamped to [minValue, maxValue]
+		kEnum,  // Stored by index into enumNames
+	};
+
+	// One INI key; the key table drives loading, legacy migration and saving
+	struct KeyDescriptor
+	{
+		const char* section;
+		const char* key;
+		ValueType type;
+		std::uint32_t defaultValue;
+		std::uint32_t (*get)(const Settings&);
+		void (*set)(Settings&, std::uint32_t);
+		const char* legacyKey = nullptr;                   // Older key in the same section whose value migrates here
+		const char* comment = nullptr;                     // Written above the key on save
+		std::span<const std::string_view> enumNames = {};  // kEnum value names
+		std::uint32_t minValue = 0;
+		std::uint32_t maxValue = std::numeric_limits<std::uint32_t>::max();
+		bool restartRequired = false;  // Only read at startup; a reload keeps the startup value
+	};
+
+	static constexpr std::size_t MAX_KEY_COUNT = 64;
+
+	// Every INI key, in the order they are written
+	static std::span<const KeyDescriptor> GetKeyDescriptors();
+
+	// Key table accessors for plain members and per-type gender toggles
+	template <auto Member>
+	static std::uint32_t GetMember(const Settings& a_settings);
+	template <auto Member>
+	static void SetMember(Settings& a_settings, std::uint32_t a_value);
+	template <RE::BGSHeadPart::HeadPartType Type, bool GenderSettings::*Gender>
+	static std::uint32_t GetGender(const Settings& a_settings);
+	template <RE::BGSHeadPart::HeadPartType Type, bool GenderSettings::*Gender>
+	static void SetGender(Settings& a_settings, std::uint32_t a_value);
+
+	// Parse and store a key's value, keeping the current value if it is invalid
+	void ParseValue(const KeyDescriptor& a_descriptor, std::string_view a_value);
+
+	// Format a key's value as written to the INI
+	static std::string FormatValue(const KeyDescriptor& a_descriptor, std::uint32_t a_value);
+
+	// Save configuration to INI file on a background thread
+	// The file is only replaced if its contents actually change
 	void SaveConfigFile(CSimpleIniA& ini, const std::string& iniPath);
 
-	std::map<RE::BGSHeadPart::HeadPartType, GenderSettings> _enabledTypes;
+	// Precompute Classify for every type and flag combination
+	void BuildClassifyTable();
+
+	GenderTable _enabledTypes;
+	HeadPartClassifier _classifier;
 	bool _verboseLogging = false;
+	bool _asyncLogging = false;
+	std::uint32_t _logQueueSize = 8192;
+	LogOverflowPolicy _logOverflowPolicy = LogOverflowPolicy::kBlock;
+	bool _generationReport = false;
 	bool _showOnlyUnisexy = false;
+	bool _hotReload = false;
+	HeadPartRules _rules;
+	std::array<RaceRemapRules, 2> _raceRemaps;  // To male, to female
+	bool _generationCache = true;
+	FormIDUtils::HashMode _formIDHashMode = FormIDUtils::HashMode::kLegacy;
+
+	// Background INI rewrite; joined before the next save and on destruction
+	std::jthread _pendingSave;
 };
@@ -0,0 +1,60 @@
+#include "SettingsWatcher.h"
+#include "PCH.h"
+#include "Settings.h"
+#include "Unisexy.h"
+
+void SettingsWatcher::Install()
+{
+	if (_installed) {
+		return;
+	}
+
+	_lastWriteTime = GetIniWriteTime();
+	if (auto* ui = RE::UI::GetSingleton()) {
+		ui->AddEventSink<RE::MenuOpenCloseEvent>(this);
+	}
+	_installed = true;
+	logger::info("Watching {} for changes", Settings::GetIniPath());
+}
+
+void SettingsWatcher::CheckForChanges()
+{
+	// Turning HotReload off in the file stops watching until the next launch
+	if (!_installed || !Settings::GetSingleton()->IsHotReload()) {
+		return;
+	}
+
+	const auto writeTime = GetIniWriteTime();
+	if (!writeTime || writeTime == _lastWriteTime) {
+		return;
+	}
+
+	logger::info("{} changed, reapplying settings", Settings::GetIniPath());
+	auto& settings = *Settings::GetSingleton();
+	settings.Load(true);
+	// Loading may rewrite the file; don't mistake that for another edit
+	settings.WaitForPendingSave();
+	_lastWriteTime = GetIniWriteTime();
+
+	Unisexy::GetSingleton()->ApplySettings();
+	spdlog::default_logger()->flush();
+}
+
+RE::BSEventNotifyControl SettingsWatcher::ProcessEvent(const RE::MenuOpenCloseEvent* a_event, RE::BSTEventSource<RE::MenuOpenCloseEvent>*)
+{
+	if (a_event && a_event->opening && a_event->menuName == RE::RaceSexMenu::MENU_NAME) {
+		// Forms are created and edited on the main thread
+		SKSE::GetTaskInterface()->AddTask([] { SettingsWatcher::GetSingleton()->CheckForChanges(); });
+	}
+	return RE::BSEventNotifyControl::kContinue;
+}
+
+std::optional<std::filesystem::file_time_type> SettingsWatcher::GetIniWriteTime()
+{
+	std::error_code ec;
+	const auto writeTime = std::filesystem::last_write_time(Settings::GetIniPath(), ec);
+	if (ec) {
+		return std::nullopt;
+	}
+	return writeTime;
+}
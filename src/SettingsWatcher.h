@@ -0,0 +1,27 @@
+#pragma once
+
+#include "RE/Skyrim.h"
+#include <ClibUtil/singleton.hpp>
+
+// Reapplies Unisexy.ini while the game is running
+// The file's modification time is checked when the race menu opens and when a save is loaded
+class SettingsWatcher :
+	public clib_util::singleton::ISingleton<SettingsWatcher>,
+	public RE::BSTEventSink<RE::MenuOpenCloseEvent>
+{
+public:
+	// Remember the INI's modification time and start watching for the race menu
+	void Install();
+
+	// Reload and apply the INI if it changed since it was last applied
+	void CheckForChanges();
+
+	RE::BSEventNotifyControl ProcessEvent(const RE::MenuOpenCloseEvent* a_event, RE::BSTEventSource<RE::MenuOpenCloseEvent>* a_eventSource) override;
+
+private:
+	// Modification time of the INI, or std::nullopt if it can't be read
+	static std::optional<std::filesystem::file_time_type> GetIniWriteTime();
+
+	std::optional<std::filesystem::file_time_type> _lastWriteTime;
+	bool _installed = false;
+};
@@ -0,0 +1,74 @@
+#pragma once
+
+// Bump-pointer arena for strings that live as long as a generation pass
+// Strings are NUL-terminated and never move, so views into the arena stay valid until it is destroyed
+class StringArena
+{
+public:
+	explicit StringArena(std::size_t a_blockSize = DEFAULT_BLOCK_SIZE) :
+		blockSize_(a_blockSize)
+	{}
+
+	StringArena(const StringArena&) = delete;
+	StringArena& operator=(const StringArena&) = delete;
+
+	// Copy the concatenation of the given pieces into the arena
+	template <class... Args>
+		requires(std::convertible_to<const Args&, std::string_view> && ...)
+	std::string_view Concat(const Args&... a_pieces)
+	{
+		const std::array<std::string_view, sizeof...(Args)> pieces{ std::string_view(a_pieces)... };
+
+		std::size_t size = 0;
+		for (const auto piece : pieces) {
+			size += piece.size();
+		}
+
+		char* const str = Allocate(size + 1);
+		char* cursor = str;
+		for (const auto piece : pieces) {
+			if (!piece.empty()) {
+				std::memcpy(cursor, piece.data(), piece.size());
+				cursor += piece.size();
+			}
+		}
+		*cursor = '\0';
+
+		stringCount_++;
+		return { str, size };
+	}
+
+	// Copy a string into the arena
+	std::string_view Intern(std::string_view a_str) { return Concat(a_str); }
+
+	std::size_t GetStringCount() const { return stringCount_; }
+	std::size_t GetBytesUsed() const { return bytesUsed_; }
+	std::size_t GetBlockCount() const { return blocks_.size(); }
+
+private:
+	static constexpr std::size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+	// Carve bytes out of the current block, starting a new block if it's full
+	char* Allocate(std::size_t a_size)
+	{
+		if (a_size > remaining_) {
+			const auto blockSize = (std::max)(blockSize_, a_size);
+			blocks_.push_back(std::make_unique_for_overwrite<char[]>(blockSize));
+			cursor_ = blocks_.back().get();
+			remaining_ = blockSize;
+		}
+
+		char* const result = cursor_;
+		cursor_ += a_size;
+		remaining_ -= a_size;
+		bytesUsed_ += a_size;
+		return result;
+	}
+
+	std::size_t blockSize_;
+	std::vector<std::unique_ptr<char[]>> blocks_;
+	char* cursor_ = nullptr;
+	std::size_t remaining_ = 0;
+	std::size_t bytesUsed_ = 0;
+	std::size_t stringCount_ = 0;
+};
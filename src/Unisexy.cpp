@@ -1,9 +1,42 @@
 #include "Unisexy.h"
-#include "FormIDManager.h"
+#include "GameHeadPartSource.h"
+#include "GenerationCache.h"
+#include "GenerationPlanner.h"
+#include "GenerationReport.h"
 #include "HeadPartUtils.h"
 #include "PCH.h"
+#include "PhaseTimer.h"
+#include "RaceRemapper.h"
 #include "Settings.h"
 
+namespace
+{
+	using Classification = Settings::Classification;
+
+	// Report file next to the log
+	std::optional<std::filesystem::path> GetReportPath()
+	{
+		auto path = logger::log_directory();
+		if (path) {
+			*path /= fmt::format("{}_Report.jsonl", Version::PROJECT);
+		}
+		return path;
+	}
+
+	// Write a generation report next to the log
+	void WriteReport(
+		const GenerationReport& a_report,
+		std::span<const std::tuple<std::string_view, std::uint32_t, std::uint32_t>> a_conflicts,
+		const GenerationReport::Summary& a_summary)
+	{
+		if (const auto reportPath = GetReportPath()) {
+			a_report.Write(*reportPath, a_conflicts, a_summary);
+		} else {
+			logger::error("Failed to find the log directory for the generation report");
+		}
+	}
+}
+
 void Unisexy::DoSexyStuff()
 {
 	logger::info("Starting Unisexy head part processing...");
@@ -18,208 +51,141 @@ void Unisexy::DoSexyStuff()
 		return;
 	}
 
-	// Processing counters
-	int createdCount = 0;
-	int processedCount = 0;
-	int failedNoSourceFile = 0;
-	int disabledOriginalCount = 0;
-	int formIDConflictCount = 0;
-	int otherWarningCount = 0;
-
-	FormIDManager formIDManager;
-	std::vector<std::tuple<std::string, std::uint32_t, std::uint32_t>> formIDConflicts;  // Track conflict details (EditorID, Conflicting FormID, Final FormID)
-
-	// Track skipped parts by type and gender for summary reporting
-	std::map<RE::BGSHeadPart::HeadPartType, std::pair<int, int>> skippedByType;  // male skips, female skips
-
-	// Only log skips and process extra parts for these major types to avoid spam
-	static const std::set<RE::BGSHeadPart::HeadPartType> reportableTypes = {
-		RE::BGSHeadPart::HeadPartType::kHair,
-		RE::BGSHeadPart::HeadPartType::kFacialHair,
-		RE::BGSHeadPart::HeadPartType::kScar,
-		RE::BGSHeadPart::HeadPartType::kEyebrows,
-	};
-
-	// Build set of existing EditorIDs to prevent duplicates
-	std::set<std::string> existingEditorIDs;
-	for (const auto& existingHeadPart : dataHandler.GetFormArray<RE::BGSHeadPart>()) {
-		if (existingHeadPart && existingHeadPart->GetFormEditorID()) {
-			existingEditorIDs.insert(existingHeadPart->GetFormEditorID());
-		}
-	}
-
-	// Cache verbose logging setting
-	const bool verboseLogging = settings.IsVerboseLogging();
-
-	// Process each head part in the data handler
-	for (const auto& headPart : dataHandler.GetFormArray<RE::BGSHeadPart>()) {
-		if (!headPart) {
-			continue;
-		}
-		processedCount++;
-
-		const auto headPartType = static_cast<RE::BGSHeadPart::HeadPartType>(headPart->type.get());
-
-		// Skip non-playable head parts
-		if (!headPart->flags.all(RE::BGSHeadPart::Flag::kPlayable)) {
-			if (verboseLogging && reportableTypes.contains(headPartType)) {
-				logger::info("Skipping non-playable head part: {} [{:08X}]",
-					headPart->GetFormEditorID(), headPart->formID);
-			}
-			continue;
-		}
-
-		// Skip kMisc head parts as they are not player selectable
-		if (headPartType == RE::BGSHeadPart::HeadPartType::kMisc) {
-			continue;
-		}
-
-		// Analyze gender flags
-		using Flag = RE::BGSHeadPart::Flag;
-		const bool isMale = headPart->flags.all(Flag::kMale);
-		const bool isFemale = headPart->flags.all(Flag::kFemale);
-		const bool isGenderless = !isMale && !isFemale;
-
-		// Handle genderless/unisex head parts
-		if (isGenderless) {
-			if (settings.IsShowOnlyUnisexy()) {
-				headPart->flags.reset(Flag::kPlayable);
-				disabledOriginalCount++;
-				if (verboseLogging) {
-					logger::info("Disabled genderless head part: {} [{:08X}] (Type: {})",
-						headPart->GetFormEditorID(), headPart->formID,
-						Settings::GetHeadPartTypeName(headPartType));
-				}
-			}
-			continue;
-		}
-
-		// Determine if this head part should be processed and target gender
-		bool shouldProcess = false;
-		bool toFemale = false;
-
-		if (isMale && !isFemale && settings.IsFemaleEnabled(headPartType)) {
-			// Convert male part to female
-			shouldProcess = true;
-			toFemale = true;
-		} else if (!isMale && isFemale && settings.IsMaleEnabled(headPartType)) {
-			// Convert female part to male
-			shouldProcess = true;
-			toFemale = false;
-		} else {
-			// Track skipped parts for summary reporting
-			if (reportableTypes.contains(headPartType)) {
-				if (isMale && !isFemale && !settings.IsFemaleEnabled(headPartType)) {
-					skippedByType[headPartType].second++;  // Female conversion disabled
-				} else if (!isMale && isFemale && !settings.IsMaleEnabled(headPartType)) {
-					skippedByType[headPartType].first++;  // Male conversion disabled
+	using Phase = PhaseTimer::Phase;
+	PhaseTimer phaseTimer;
+
+	std::vector<HeadPartUtils::CreatedHeadPart> createdParts;  // Track created parts for the generation cache
+	std::vector<RE::FormID> disabledParts;                     // Track originals hidden by ShowOnlyUnisexy
+
+	// Race remapping applies to restored and generated parts alike
+	auto& raceRemapper = *RaceRemapper::GetSingleton();
+	raceRemapper.Build(settings);
+
+	// A later pass only fills in newly enabled toggles, which the cache knows nothing about
+	const bool isFirstPass = !_hasGenerated;
+
+	// Recreate the previous launch's head parts for every plugin whose head parts are unchanged
+	const bool useGenerationCache = isFirstPass && settings.IsGenerationCacheEnabled();
+	std::uint64_t cacheKey = 0;
+	std::vector<PluginFingerprint> pluginFingerprints;
+	std::unordered_set<const RE::TESFile*> unchangedFiles;  // Plugins whose parts were restored from the cache
+	if (useGenerationCache) {
+		const auto timer = phaseTimer.Measure(Phase::kCacheLoad);
+		auto& generationCache = *GenerationCache::GetSingleton();
+		cacheKey = GenerationCache::ComputeKey(settings);
+		// Fingerprint before restoring anything, as restored parts join the head part array
+		pluginFingerprints = GenerationCache::ComputeFingerprints(dataHandler);
+
+		GenerationCacheFormat::View cachedPlan;
+		if (generationCache.Load(cacheKey, cachedPlan)) {
+			auto reusablePlan = HeadPartUtils::SelectUnchangedParts(cachedPlan, pluginFingerprints, unchangedFiles);
+			if (!unchangedFiles.empty() && HeadPartUtils::InstantiatePlan(headFactory, reusablePlan, settings, true, createdParts, disabledParts)) {
+				logger::info("Restored {} head parts from {} of {} plugins from the generation cache.",
+					createdParts.size(), unchangedFiles.size(), pluginFingerprints.size());
+			} else {
+				if (!unchangedFiles.empty()) {
+					logger::info("Generation cache is stale. Regenerating head parts.");
 				}
+				unchangedFiles.clear();
 			}
-			continue;
-		}
-
-		// Generate EditorID for the new head part
-		const std::string newEditorID = HeadPartUtils::GenerateUnisexyEditorID(headPart);
-		if (newEditorID.empty()) {
-			otherWarningCount++;  // Increment for missing EditorID
-			continue;
-		}
-
-		// Skip if we already created this head part
-		if (existingEditorIDs.count(newEditorID) > 0) {
-			if (verboseLogging) {
-				logger::info("Skipping duplicate head part: {}", newEditorID);
-			}
-			continue;
 		}
 
-		// Create the new gender-flipped head part
-		auto* newHeadPart = HeadPartUtils::CreateUnisexyHeadPart(
-			headFactory, headPart, newEditorID, toFemale, settings);
-		if (!newHeadPart) {
-			otherWarningCount++;  // Increment for memory allocation failure
-			continue;
+		// The view and the plan read from it point into the mapped cache file; release it so the cache can be rewritten
+		cachedPlan = {};
+		generationCache.Close();
+	}
+	const auto restoredCount = createdParts.size();
+
+	// Every plugin was restored from the cache, so there is nothing to plan
+	if (!pluginFingerprints.empty() && unchangedFiles.size() == pluginFingerprints.size()) {
+		const auto duration = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - startTime).count();
+		logger::info("Processing completed in {:.2f} seconds. Restored {} head parts and disabled {} original parts from the generation cache.",
+			duration, restoredCount, disabledParts.size());
+		// The restored parts hold their FormIDs, so the race lists built for them can't take one
+		raceRemapper.RegisterLists(settings);
+		RecordPass(createdParts, disabledParts);
+
+		// Replace the previous report so it doesn't describe an older pass
+		if (settings.IsGenerationReportEnabled()) {
+			const auto timer = phaseTimer.Measure(Phase::kReport);
+			GenerationReport::Summary summary;
+			summary.createdCount = restoredCount;
+			summary.restoredCount = restoredCount;
+			summary.disabledCount = disabledParts.size();
+			summary.seconds = duration;
+			WriteReport(GenerationReport{}, {}, summary);
 		}
 
-		// Get source file for FormID assignment
-		const RE::TESFile* targetFile = headPart->GetFile();
-		if (!targetFile) {
-			failedNoSourceFile++;
-			logger::error("No source file found for head part {} [{:08X}]. Skipping.",
-				headPart->GetFormEditorID(), headPart->formID);
-			delete newHeadPart;
-			continue;
-		}
+		phaseTimer.LogSummary();
+		return;
+	}
 
-		// Assign FormID to the new head part
-		std::uint32_t conflictFormID = 0;
-		if (!formIDManager.AssignFormID(newHeadPart, targetFile, conflictFormID)) {
-			formIDConflictCount++;                                         // Increment for FormID conflict
-			formIDConflicts.emplace_back(newEditorID, conflictFormID, 0);  // Store conflict with no final FormID
-			logger::error("Failed to assign FormID for {}", newEditorID);
-			delete newHeadPart;
-			continue;
-		}
+	// Snapshot the head parts the planner reads; restored parts are already part of it
+	std::optional<GameHeadPartSource> source;
+	{
+		const auto timer = phaseTimer.Measure(Phase::kSnapshot);
+		source.emplace(dataHandler);
+	}
 
-		// Store conflict details if there was a conflict
-		if (conflictFormID != 0) {
-			formIDConflicts.emplace_back(newEditorID, conflictFormID, newHeadPart->formID);
-			formIDConflictCount++;  // Increment for resolved conflict
+	GenerationPlanner::Options options;
+	options.classifier = &settings.GetClassifier();
+	options.rules = &settings.GetRules();
+	options.hashMode = settings.GetFormIDHashMode();
+	options.showOnlyUnisexy = settings.IsShowOnlyUnisexy();
+	options.verboseLogging = settings.IsVerboseLogging();
+	options.skippedToggles = _generatedToggles;
+	for (const auto* file : unchangedFiles) {
+		if (const auto* plugin = source->FindPlugin(file)) {
+			options.skippedFiles.insert(plugin);
 		}
+	}
+	for (const auto& createdPart : _createdParts) {
+		options.skippedSources.insert(createdPart.headPart->formID);
+	}
 
-		// Set the file for the new head part
-		newHeadPart->SetFile(const_cast<RE::TESFile*>(targetFile));
-
-		// Process extra parts
-		if (reportableTypes.contains(headPartType)) {
-			if (!HeadPartUtils::ProcessExtraParts(
-					newHeadPart, headPart, formIDManager, targetFile,
-					existingEditorIDs, settings, createdCount, formIDConflicts)) {
-				logger::error("Failed to process extra parts for {}", newEditorID);
-				otherWarningCount++;  // Increment for extra parts processing failure
-				delete newHeadPart;
-				continue;
-			}
-		}
+	// Collect per-part records for the machine-readable report if enabled
+	std::optional<GenerationReport> report;
+	if (settings.IsGenerationReportEnabled()) {
+		report.emplace();
+	}
 
-		// Register the new head part with the data handler
-		dataHandler.AddFormToDataHandler(newHeadPart);
-		existingEditorIDs.insert(newEditorID);
-		createdCount++;
+	// Plan every new head part; FormIDs are reserved but nothing is created yet
+	GenerationPlanner planner(*source, std::move(options));
+	planner.Plan(phaseTimer, report ? &*report : nullptr);
+	const auto& generationPlan = planner.GetPlan();
+	const auto& stats = planner.GetStats();
+	const bool verboseLogging = settings.IsVerboseLogging();
+	int otherWarningCount = stats.otherWarningCount;
 
+	// Create and register exactly the planned head parts, extra parts before their parents, in one batch
+	{
+		const auto timer = phaseTimer.Measure(Phase::kCreate);
 		if (verboseLogging) {
-			logger::info("Created head part: {} [{:08X}] (Type: {}) from source [{:08X}]",
-				newEditorID, newHeadPart->formID,
-				Settings::GetHeadPartTypeName(headPartType),
-				headPart->formID);
-		}
-
-		// Disable original head part if configured to show only Unisexy versions
-		if (settings.IsShowOnlyUnisexy()) {
-			headPart->flags.reset(Flag::kPlayable);
-			disabledOriginalCount++;
-			if (verboseLogging) {
-				logger::info("Disabled original head part: {} [{:08X}] (Type: {})",
-					headPart->GetFormEditorID(), headPart->formID,
-					Settings::GetHeadPartTypeName(headPartType));
-			}
+			logger::info("Creating {} planned head parts", generationPlan.headParts.size());
 		}
+		const auto createdBefore = createdParts.size();
+		HeadPartUtils::InstantiatePlan(headFactory, generationPlan, settings, false, createdParts, disabledParts);
+		// Increment for planned parts that could not be created or allocated
+		otherWarningCount += static_cast<int>(generationPlan.headParts.size() - (createdParts.size() - createdBefore));
 	}
 
 	// Calculate processing time and log summary
 	const auto endTime = std::chrono::high_resolution_clock::now();
 	const auto duration = std::chrono::duration<double>(endTime - startTime).count();
 	logger::info("Processing completed in {:.2f} seconds. Processed {} head parts, created {} new parts, disabled {} original parts.",
-		duration, processedCount, createdCount, disabledOriginalCount);
+		duration, stats.processedCount, createdParts.size(), stats.disabledOriginalCount);
 
-	if (failedNoSourceFile > 0) {
-		logger::info("Failed to process {} head parts due to missing source files.", failedNoSourceFile);
+	if (stats.failedNoSourceFile > 0) {
+		logger::info("Failed to process {} head parts due to missing source files.", stats.failedNoSourceFile);
 	}
 
 	// Report skipped parts and warnings summary only if verbose logging is enabled
 	if (verboseLogging) {
+		const auto timer = phaseTimer.Measure(Phase::kSummary);
+
+		const auto& skippedByType = planner.GetSkippedByType();
 		bool loggedAnySkips = false;
-		for (const auto& type : reportableTypes) {
+		for (const auto type : GenerationPlanner::REPORTABLE_TYPES) {
 			const auto it = skippedByType.find(type);
 			if (it != skippedByType.end() && (it->second.first > 0 || it->second.second > 0)) {
 				if (!loggedAnySkips) {
@@ -227,10 +193,10 @@ void Unisexy::DoSexyStuff()
 					loggedAnySkips = true;
 				}
 				if (it->second.first > 0) {
-					logger::info("  {} (Male conversion): {}", Settings::GetHeadPartTypeName(type), it->second.first);
+					logger::info("  {} (Male conversion): {}", GetHeadPartTypeName(type), it->second.first);
 				}
 				if (it->second.second > 0) {
-					logger::info("  {} (Female conversion): {}", Settings::GetHeadPartTypeName(type), it->second.second);
+					logger::info("  {} (Female conversion): {}", GetHeadPartTypeName(type), it->second.second);
 				}
 			}
 		}
@@ -238,15 +204,25 @@ void Unisexy::DoSexyStuff()
 			logger::info("No head parts were skipped due to disabled settings.");
 		}
 
+		const auto& arena = planner.GetArena();
+		const auto& resolver = planner.GetResolver();
+		logger::info("Generated {} EditorIDs using {} bytes in {} arena blocks",
+			arena.GetStringCount(), arena.GetBytesUsed(), arena.GetBlockCount());
+		logger::info("Resolved {} unique extra parts, {} lookups reused an earlier resolution, deepest chain {}",
+			resolver.GetResolvedCount(), resolver.GetMemoHitCount(), resolver.GetMaxDepth());
+		if (raceRemapper.GetListCount() > 0) {
+			logger::info("Built {} remapped race lists", raceRemapper.GetListCount());
+		}
+
 		// Log warnings summary
 		logger::info("Warning summary:");
-		logger::info("  FormID conflicts: {}", formIDConflictCount);
+		logger::info("  FormID conflicts: {}", stats.formIDConflictCount);
 		logger::info("  Other issues (missing EditorIDs, memory allocation failures, extra parts processing failures): {}", otherWarningCount);
-		if (formIDConflictCount == 0 && otherWarningCount == 0) {
+		if (stats.formIDConflictCount == 0 && otherWarningCount == 0) {
 			logger::info("  No warnings encountered during processing.");
-		} else if (formIDConflictCount > 0) {
+		} else if (stats.formIDConflictCount > 0) {
 			logger::info("  FormID conflict details:");
-			for (const auto& [editorID, conflictFormID, finalFormID] : formIDConflicts) {
+			for (const auto& [editorID, conflictFormID, finalFormID] : planner.GetConflicts()) {
 				if (finalFormID != 0) {
 					logger::info("    - {} [{:08X}] conflicted with [{:08X}], assigned [{:08X}]",
 						editorID, conflictFormID, conflictFormID, finalFormID);
@@ -257,4 +233,158 @@ void Unisexy::DoSexyStuff()
 			}
 		}
 	}
+
+	// Write the machine-readable report in one pass
+	if (report) {
+		const auto timer = phaseTimer.Measure(Phase::kReport);
+		GenerationReport::Summary summary;
+		summary.processedCount = stats.processedCount;
+		summary.createdCount = createdParts.size();
+		summary.restoredCount = restoredCount;
+		summary.disabledCount = stats.disabledOriginalCount;
+		summary.formIDConflictCount = stats.formIDConflictCount;
+		summary.otherWarningCount = otherWarningCount;
+		summary.seconds = duration;
+		summary.skippedByType = &planner.GetSkippedByType();
+		WriteReport(*report, planner.GetConflicts(), summary);
+	}
+
+	// Every head part of the pass holds its FormID, so the race lists built for them can't take one
+	raceRemapper.RegisterLists(settings);
+	RecordPass(createdParts, disabledParts);
+
+	// Persist what was generated so the next launch can skip regeneration
+	if (useGenerationCache) {
+		const auto timer = phaseTimer.Measure(Phase::kCacheSave);
+		GenerationCache::GetSingleton()->Save(cacheKey, HeadPartUtils::BuildPlan(createdParts, std::move(disabledParts), std::move(pluginFingerprints)));
+	}
+
+	// Report per-phase timings to locate startup cost regressions
+	phaseTimer.LogSummary();
+}
+
+void Unisexy::ApplySettings()
+{
+	const auto& settings = *Settings::GetSingleton();
+
+	// Only run a generation pass if a toggle is enabled that no earlier pass generated parts for
+	bool hasNewToggles = false;
+	for (std::uint32_t type = 0; type < std::to_underlying(RE::BGSHeadPart::HeadPartType::kTotal); ++type) {
+		const auto headPartType = static_cast<RE::BGSHeadPart::HeadPartType>(type);
+		const auto toggleType = static_cast<HeadPartType>(type);
+		if ((settings.IsMaleEnabled(headPartType) && !_generatedToggles.test(GetToggleIndex(toggleType, false))) ||
+			(settings.IsFemaleEnabled(headPartType) && !_generatedToggles.test(GetToggleIndex(toggleType, true)))) {
+			hasNewToggles = true;
+			break;
+		}
+	}
+	if (hasNewToggles) {
+		DoSexyStuff();
+	}
+
+	UpdatePlayableFlags();
+}
+
+void Unisexy::RecordPass(const std::vector<HeadPartUtils::CreatedHeadPart>& a_createdParts, std::span<const RE::FormID> a_disabledParts)
+{
+	const auto& settings = *Settings::GetSingleton();
+
+	_createdParts.reserve(_createdParts.size() + a_createdParts.size());
+	for (const auto& createdPart : a_createdParts) {
+		_createdParts.push_back(createdPart);
+		_createdSet.insert(createdPart.headPart);
+	}
+	_hiddenParts.insert(a_disabledParts.begin(), a_disabledParts.end());
+
+	for (std::uint32_t type = 0; type < std::to_underlying(RE::BGSHeadPart::HeadPartType::kTotal); ++type) {
+		const auto headPartType = static_cast<RE::BGSHeadPart::HeadPartType>(type);
+		const auto toggleType = static_cast<HeadPartType>(type);
+		if (settings.IsMaleEnabled(headPartType)) {
+			_generatedToggles.set(GetToggleIndex(toggleType, false));
+		}
+		if (settings.IsFemaleEnabled(headPartType)) {
+			_generatedToggles.set(GetToggleIndex(toggleType, true));
+		}
+	}
+	_hasGenerated = true;
+}
+
+void Unisexy::UpdatePlayableFlags()
+{
+	using Flag = RE::BGSHeadPart::Flag;
+
+	const auto& settings = *Settings::GetSingleton();
+	const bool showOnlyUnisexy = settings.IsShowOnlyUnisexy();
+
+	// Classify as if Unisexy had never hidden anything
+	const auto classifyOriginal = [&](const RE::BGSHeadPart* a_headPart) {
+		auto flags = a_headPart->flags;
+		if (_hiddenParts.contains(a_headPart->formID)) {
+			flags.set(Flag::kPlayable);
+		}
+		return settings.Classify(static_cast<RE::BGSHeadPart::HeadPartType>(a_headPart->type.get()), flags);
+	};
+	const auto isFlipped = [](Classification a_classification) {
+		return a_classification == Classification::kToFemale || a_classification == Classification::kToMale;
+	};
+
+	// A generated part is shown while its source would still be flipped; extra parts are left alone
+	std::unordered_set<RE::FormID> hiddenParts;
+	std::unordered_set<RE::FormID> flippedSources;
+	int shownCount = 0;
+	int hiddenCount = 0;
+	for (const auto& createdPart : _createdParts) {
+		const auto* source = createdPart.source;
+		auto* headPart = createdPart.headPart;
+		if (!source || !headPart) {
+			continue;
+		}
+
+		const auto classification = classifyOriginal(source);
+		if (isFlipped(classification)) {
+			flippedSources.insert(source->formID);
+			if (headPart->flags.none(Flag::kPlayable)) {
+				headPart->flags.set(Flag::kPlayable);
+				shownCount++;
+			}
+		} else if (classification == Classification::kMaleDisabled || classification == Classification::kFemaleDisabled) {
+			if (headPart->flags.all(Flag::kPlayable)) {
+				headPart->flags.reset(Flag::kPlayable);
+				hiddenCount++;
+			}
+		}
+	}
+
+	// ShowOnlyUnisexy hides originals that currently have a flipped version, and genderless parts
+	if (showOnlyUnisexy) {
+		for (const auto& headPart : RE::TESDataHandler::GetSingleton()->GetFormArray<RE::BGSHeadPart>()) {
+			if (!headPart || _createdSet.contains(headPart)) {
+				continue;
+			}
+			const auto classification = classifyOriginal(headPart);
+			if (classification == Classification::kGenderless || (isFlipped(classification) && flippedSources.contains(headPart->formID))) {
+				hiddenParts.insert(headPart->formID);
+			}
+		}
+	}
+
+	// Only touch the parts whose state changes
+	for (const auto formID : _hiddenParts) {
+		if (!hiddenParts.contains(formID)) {
+			if (auto* headPart = RE::TESForm::LookupByID<RE::BGSHeadPart>(formID)) {
+				headPart->flags.set(Flag::kPlayable);
+			}
+		}
+	}
+	for (const auto formID : hiddenParts) {
+		if (!_hiddenParts.contains(formID)) {
+			if (auto* headPart = RE::TESForm::LookupByID<RE::BGSHeadPart>(formID)) {
+				headPart->flags.reset(Flag::kPlayable);
+			}
+		}
+	}
+
+	logger::info("Applied settings: showed {} and hid {} generated head parts, {} original parts hidden",
+		shownCount, hiddenCount, hiddenParts.size());
+	_hiddenParts = std::move(hiddenParts);
 }
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "GenerationPlanner.h"
+#include "HeadPartUtils.h"
 #include <ClibUtil/singleton.hpp>
 
 class Unisexy : public clib_util::singleton::ISingleton<Unisexy>
@@ -7,5 +9,23 @@ class Unisexy : public clib_util::singleton::ISingleton<Unisexy>
 public:
 	// Main processing function - creates gender-flipped versions of head parts
 	// based on configuration settings loaded from Unisexy.ini
+	// Later calls only create parts for type and gender toggles that weren't enabled in an earlier pass
 	void DoSexyStuff();
+
+	// Bring the generated head parts in line with reloaded settings
+	// Creates parts for newly enabled toggles, then shows or hides generated and original parts to match
+	void ApplySettings();
+
+private:
+	// Remember what a generation pass created and hid
+	void RecordPass(const std::vector<HeadPartUtils::CreatedHeadPart>& a_createdParts, std::span<const RE::FormID> a_disabledParts);
+
+	// Set the playable flag of generated and original head parts from the current settings
+	void UpdatePlayableFlags();
+
+	std::vector<HeadPartUtils::CreatedHeadPart> _createdParts;  // Every head part generated so far
+	std::unordered_set<const RE::BGSHeadPart*> _createdSet;      // Generated parts, never used as sources
+	std::unordered_set<RE::FormID> _hiddenParts;                 // Parts whose playable flag Unisexy reset
+	HeadPartToggles _generatedToggles;                           // Toggles an earlier pass generated parts for
+	bool _hasGenerated = false;
 };
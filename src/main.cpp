@@ -1,15 +1,52 @@
+#include "GenerationCache.h"
 #include "PCH.h"
 #include "Settings.h"
+#include "SettingsWatcher.h"
 #include "Unisexy.h"
+#include <spdlog/async.h>
+
+// Switch the default logger to an async logger over the same sinks if configured
+void ApplyLogSettings(const Settings& a_settings)
+{
+	if (!a_settings.IsAsyncLogging()) {
+		return;
+	}
+
+	const auto policy = a_settings.GetLogOverflowPolicy() == Settings::LogOverflowPolicy::kDropOldest ?
+	                        spdlog::async_overflow_policy::overrun_oldest :
+	                        spdlog::async_overflow_policy::block;
+
+	spdlog::init_thread_pool(a_settings.GetLogQueueSize(), 1);
+	const auto& sinks = spdlog::default_logger()->sinks();
+	auto log = std::make_shared<spdlog::async_logger>("global log"s, sinks.begin(), sinks.end(), spdlog::thread_pool(), policy);
+	log->set_level(spdlog::level::info);
+	// Warnings and errors still reach the file promptly; the rest is flushed periodically and after processing
+	log->flush_on(spdlog::level::warn);
+
+	spdlog::set_default_logger(std::move(log));
+	spdlog::flush_every(std::chrono::seconds(5));
+
+	logger::info("Async logging enabled (queue size {})", a_settings.GetLogQueueSize());
+}
 
 void OnInit(SKSE::MessagingInterface::Message* a_msg)
 {
 	switch (a_msg->type) {
 	case SKSE::MessagingInterface::kPostLoad:
 		Settings::GetSingleton()->Load();
+		ApplyLogSettings(*Settings::GetSingleton());
+		GenerationCache::GetSingleton()->Open();
 		break;
 	case SKSE::MessagingInterface::kDataLoaded:
+		Settings::GetSingleton()->WaitForPendingSave();
 		Unisexy::GetSingleton()->DoSexyStuff();
+		if (Settings::GetSingleton()->IsHotReload()) {
+			SettingsWatcher::GetSingleton()->Install();
+		}
+		spdlog::default_logger()->flush();
+		break;
+	case SKSE::MessagingInterface::kPostLoadGame:
+		SettingsWatcher::GetSingleton()->CheckForChanges();
 		break;
 	default:
 		break;
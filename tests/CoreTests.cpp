@@ -0,0 +1,290 @@
+#include "FormIDBitmap.h"
+#include "FormIDManager.h"
+#include "FormIDUtils.h"
+#include "Hash.h"
+#include "HeadPartClassifier.h"
+#include "HeadPartRules.h"
+#include "MemoryHeadPartSource.h"
+#include "StringArena.h"
+
+#include <gtest/gtest.h>
+
+namespace
+{
+	constexpr std::uint8_t PLAYABLE_MALE = std::to_underlying(HeadPartFlag::kPlayable) | std::to_underlying(HeadPartFlag::kMale);
+	constexpr std::uint8_t PLAYABLE_FEMALE = std::to_underlying(HeadPartFlag::kPlayable) | std::to_underlying(HeadPartFlag::kFemale);
+
+	// Classification decided branch by branch, the way it was before the table
+	HeadPartClassifier::Classification ClassifyByBranches(
+		std::span<const HeadPartClassifier::TypeToggles, HeadPartClassifier::TYPE_COUNT> a_toggles,
+		HeadPartType a_type,
+		std::uint8_t a_flags)
+	{
+		using Classification = HeadPartClassifier::Classification;
+		const bool isMale = (a_flags & std::to_underlying(HeadPartFlag::kMale)) != 0;
+		const bool isFemale = (a_flags & std::to_underlying(HeadPartFlag::kFemale)) != 0;
+		if ((a_flags & std::to_underlying(HeadPartFlag::kPlayable)) == 0) {
+			return Classification::kNonPlayable;
+		}
+		if (a_type == HeadPartType::kMisc) {
+			return Classification::kMisc;
+		}
+		if (isMale && isFemale) {
+			return Classification::kBothGenders;
+		}
+		if (!isMale && !isFemale) {
+			return Classification::kGenderless;
+		}
+		const auto& toggles = a_toggles[std::to_underlying(a_type)];
+		if (isMale) {
+			return toggles.femaleEnabled ? Classification::kToFemale : Classification::kFemaleDisabled;
+		}
+		return toggles.maleEnabled ? Classification::kToMale : Classification::kMaleDisabled;
+	}
+}
+
+TEST(Hash, StableFormIDsNeverChange)
+{
+	// Saves reference these FormIDs; the same values are pinned at compile time in FormIDUtils.h
+	EXPECT_EQ(FormIDUtils::GenerateBaseFormID(Hash::HashedKey("HairMaleNord01_Unisexy"), false, FormIDUtils::HashMode::kStable), 0x41D21Bu);
+	EXPECT_EQ(FormIDUtils::GenerateBaseFormID(Hash::HashedKey("HairMaleNord01_Unisexy"), true, FormIDUtils::HashMode::kMigrate), 0xA1Bu);
+}
+
+TEST(Hash, HasherPrefixesStringLengths)
+{
+	Hash::Hasher ab;
+	ab.Update("ab"sv);
+	ab.Update("c"sv);
+	Hash::Hasher a;
+	a.Update("a"sv);
+	a.Update("bc"sv);
+	EXPECT_NE(ab.Get(), a.Get());
+}
+
+TEST(FormIDUtils, HashStaysInLocalRange)
+{
+	for (std::uint64_t hash : { 0ull, 1ull, 0xFFFFFFFFFFFFFFFFull, 0x123456789ABCDEFull }) {
+		for (const bool isLight : { false, true }) {
+			const auto localID = FormIDUtils::HashToLocalID(hash, isLight);
+			EXPECT_GE(localID, FormIDUtils::FORMID_MIN);
+			EXPECT_LE(localID, FormIDUtils::GetMaxLocalID(isLight));
+		}
+	}
+}
+
+TEST(FormIDBitmap, FindFreeCountsDownThenWraps)
+{
+	FormIDBitmap bitmap(true);
+	EXPECT_EQ(bitmap.FindFree(0x900), 0x900u);
+
+	bitmap.Set(0x900);
+	bitmap.Set(0x8FF);
+	EXPECT_TRUE(bitmap.Test(0x900));
+	EXPECT_FALSE(bitmap.Test(0x901));
+	EXPECT_EQ(bitmap.FindFree(0x900), 0x8FEu);
+
+	// Everything below is taken, so the search wraps to the top of the range
+	for (std::uint32_t localID = FormIDUtils::FORMID_MIN; localID <= 0x900; ++localID) {
+		bitmap.Set(localID);
+	}
+	EXPECT_EQ(bitmap.FindFree(0x900), FormIDUtils::ESL_HIGH_START);
+}
+
+TEST(FormIDBitmap, ExhaustedRangeHasNoFreeID)
+{
+	FormIDBitmap bitmap(true);
+	for (std::uint32_t localID = FormIDUtils::FORMID_MIN; localID <= FormIDUtils::ESL_HIGH_START; ++localID) {
+		bitmap.Set(localID);
+	}
+	EXPECT_EQ(bitmap.FindFree(0xA00), std::nullopt);
+}
+
+TEST(FormIDBitmap, FullPluginScansAcrossPages)
+{
+	FormIDBitmap bitmap(false);
+	for (std::uint32_t localID = 0x2000; localID <= 0x3FFF; ++localID) {
+		bitmap.Set(localID);
+	}
+	EXPECT_EQ(bitmap.FindFree(0x3FFF), 0x1FFFu);
+}
+
+TEST(StringArena, StringsStayValidAcrossBlocks)
+{
+	StringArena arena(16);
+	const auto first = arena.Concat("HairMale"sv, "_Unisexy"sv);
+	std::vector<std::string_view> strings;
+	for (int i = 0; i < 100; ++i) {
+		strings.push_back(arena.Intern(std::to_string(i)));
+	}
+
+	EXPECT_EQ(first, "HairMale_Unisexy");
+	EXPECT_EQ(first.data()[first.size()], '\0');
+	for (int i = 0; i < 100; ++i) {
+		EXPECT_EQ(strings[i], std::to_string(i));
+	}
+	EXPECT_EQ(arena.GetStringCount(), 101u);
+	EXPECT_GT(arena.GetBlockCount(), 1u);
+}
+
+TEST(HeadPartRules, IncludeAndExcludePatterns)
+{
+	HeadPartRules rules;
+	rules.Add(HeadPartRules::Kind::kIncludePlugin, "KS Hairdo*.esp");
+	rules.Add(HeadPartRules::Kind::kExcludeEditorID, "*Beard??");
+
+	EXPECT_TRUE(rules.HasPluginRules());
+	EXPECT_TRUE(rules.IsPluginAllowed("ks hairdos.esp"));
+	EXPECT_FALSE(rules.IsPluginAllowed("Skyrim.esm"));
+	EXPECT_TRUE(rules.IsEditorIDAllowed("HairMaleNord01"));
+	EXPECT_FALSE(rules.IsEditorIDAllowed("MaleBeard01"));
+}
+
+TEST(HeadPartClassifier, ClassifiesEveryFlagCombination)
+{
+	std::array<HeadPartClassifier::TypeToggles, HeadPartClassifier::TYPE_COUNT> toggles{};
+	toggles[std::to_underlying(HeadPartType::kHair)] = { true, false };
+	toggles[std::to_underlying(HeadPartType::kMisc)] = { true, true };
+
+	HeadPartClassifier classifier;
+	classifier.Build(toggles);
+
+	using Classification = HeadPartClassifier::Classification;
+	constexpr auto playable = std::to_underlying(HeadPartFlag::kPlayable);
+	EXPECT_EQ(classifier.Classify(HeadPartType::kHair, PLAYABLE_FEMALE), Classification::kToMale);
+	EXPECT_EQ(classifier.Classify(HeadPartType::kHair, PLAYABLE_MALE), Classification::kFemaleDisabled);
+	EXPECT_EQ(classifier.Classify(HeadPartType::kHair, PLAYABLE_MALE | PLAYABLE_FEMALE), Classification::kBothGenders);
+	EXPECT_EQ(classifier.Classify(HeadPartType::kHair, playable), Classification::kGenderless);
+	EXPECT_EQ(classifier.Classify(HeadPartType::kHair, std::to_underlying(HeadPartFlag::kFemale)), Classification::kNonPlayable);
+	EXPECT_EQ(classifier.Classify(HeadPartType::kMisc, PLAYABLE_FEMALE), Classification::kMisc);
+	EXPECT_EQ(classifier.Classify(HeadPartType::kEyebrows, PLAYABLE_FEMALE), Classification::kMaleDisabled);
+	EXPECT_EQ(classifier.Classify(static_cast<HeadPartType>(42), PLAYABLE_FEMALE), Classification::kMaleDisabled);
+}
+
+TEST(HeadPartClassifier, MatchesTheBranchesForEveryToggleCombination)
+{
+	constexpr std::size_t toggleBits = HeadPartClassifier::TYPE_COUNT * 2;
+	for (std::uint32_t bits = 0; bits < (1u << toggleBits); ++bits) {
+		std::array<HeadPartClassifier::TypeToggles, HeadPartClassifier::TYPE_COUNT> toggles{};
+		for (std::size_t type = 0; type < toggles.size(); ++type) {
+			toggles[type] = { (bits >> (type * 2) & 1) != 0, (bits >> (type * 2 + 1) & 1) != 0 };
+		}
+		HeadPartClassifier classifier;
+		classifier.Build(toggles);
+
+		for (std::size_t type = 0; type < HeadPartClassifier::TYPE_COUNT; ++type) {
+			for (std::uint8_t flags = 0; flags < 8; ++flags) {
+				const auto headPartType = static_cast<HeadPartType>(type);
+				ASSERT_EQ(classifier.Classify(headPartType, flags), ClassifyByBranches(toggles, headPartType, flags))
+					<< "toggles " << bits << ", type " << type << ", flags " << static_cast<int>(flags);
+			}
+		}
+	}
+}
+
+TEST(FormIDManager, MovesConflictsToTheNextFreeID)
+{
+	MemoryHeadPartSource source;
+	const auto* plugin = source.AddPlugin("Hair.esl", true);
+	const Hash::HashedKey editorID("HairMaleNord01_Unisexy");
+	const auto hashedID = FormIDUtils::GenerateBaseFormID(editorID, true, FormIDUtils::HashMode::kStable);
+	source.AddForm(FormIDUtils::MakeFormID(plugin->compileIndex, true, hashedID), "Taken");
+	source.Finalize();
+
+	FormIDManager formIDManager(source, FormIDUtils::HashMode::kStable, false);
+	std::uint32_t conflictFormID = 0;
+	const auto formID = formIDManager.AssignFormID(editorID, plugin, conflictFormID);
+
+	EXPECT_EQ(conflictFormID, FormIDUtils::MakeFormID(plugin->compileIndex, true, hashedID));
+	EXPECT_EQ(formID, FormIDUtils::MakeFormID(plugin->compileIndex, true, hashedID - 1));
+
+	// The same EditorID again conflicts with the FormID just assigned
+	const auto nextFormID = formIDManager.AssignFormID(editorID, plugin, conflictFormID);
+	EXPECT_EQ(nextFormID, FormIDUtils::MakeFormID(plugin->compileIndex, true, hashedID - 2));
+}
+
+TEST(FormIDManager, PreScanFindsWhatScansOnFirstUseFind)
+{
+	MemoryHeadPartSource source;
+	const auto* full = source.AddPlugin("Hair.esp", false);
+	const auto* light = source.AddPlugin("Hair.esl", true);
+	const auto* other = source.AddPlugin("Other.esp", false);
+	const Hash::HashedKey editorID("HairMaleNord01_Unisexy");
+	const std::array targetFiles{ full, light };
+	for (const auto* plugin : targetFiles) {
+		const auto hashedID = FormIDUtils::GenerateBaseFormID(editorID, plugin->isLight, FormIDUtils::HashMode::kStable);
+		ASSERT_GE(hashedID, FormIDUtils::FORMID_MIN + 2);
+		source.AddForm(FormIDUtils::MakeFormID(plugin->compileIndex, plugin->isLight, hashedID), "Taken");
+		source.AddForm(FormIDUtils::MakeFormID(plugin->compileIndex, plugin->isLight, hashedID - 1), "Taken");
+		// The same local FormID in another plugin is no conflict
+		source.AddForm(FormIDUtils::MakeFormID(other->compileIndex, false, hashedID - 2), "Elsewhere");
+	}
+	source.Finalize();
+
+	FormIDManager preScanned(source, FormIDUtils::HashMode::kStable, false);
+	preScanned.SeedOccupancy(targetFiles);
+	FormIDManager scannedOnFirstUse(source, FormIDUtils::HashMode::kStable, false);
+	for (const auto* plugin : targetFiles) {
+		const auto hashedID = FormIDUtils::GenerateBaseFormID(editorID, plugin->isLight, FormIDUtils::HashMode::kStable);
+		std::uint32_t conflictFormID = 0;
+		std::uint32_t firstUseConflictFormID = 0;
+		const auto formID = preScanned.AssignFormID(editorID, plugin, conflictFormID);
+		EXPECT_EQ(formID, FormIDUtils::MakeFormID(plugin->compileIndex, plugin->isLight, hashedID - 2));
+		EXPECT_EQ(conflictFormID, FormIDUtils::MakeFormID(plugin->compileIndex, plugin->isLight, hashedID));
+		EXPECT_EQ(scannedOnFirstUse.AssignFormID(editorID, plugin, firstUseConflictFormID), formID);
+		EXPECT_EQ(firstUseConflictFormID, conflictFormID);
+	}
+}
+
+TEST(FormIDManager, ReplaysTheLegacyCountDownInMigrateMode)
+{
+	// At compile index 0 older builds checked the FormIDs they meant to
+	MemoryHeadPartSource source;
+	const auto* plugin = source.AddPlugin("Hair.esp", false);
+	const Hash::HashedKey editorID("HairMaleNord01_Unisexy");
+	const Hash::HashedKey crowdedEditorID("HairFemaleImperial1_Unisexy");
+	const auto legacyID = FormIDUtils::GenerateLegacyBaseFormID(editorID.str, false);
+	const auto crowdedLegacyID = FormIDUtils::GenerateLegacyBaseFormID(crowdedEditorID.str, false);
+	ASSERT_GE(legacyID, FormIDUtils::FORMID_MIN + 2);
+	ASSERT_GE(crowdedLegacyID, FormIDUtils::FORMID_MIN + 10);
+	source.AddForm(FormIDUtils::MakeFormID(plugin->compileIndex, false, legacyID), "Taken");
+	for (std::uint32_t i = 0; i < 10; ++i) {
+		source.AddForm(FormIDUtils::MakeFormID(plugin->compileIndex, false, crowdedLegacyID - i), "Crowded");
+	}
+	source.Finalize();
+
+	FormIDManager formIDManager(source, FormIDUtils::HashMode::kMigrate, false);
+	EXPECT_EQ(formIDManager.AssignLegacyFormID(editorID, plugin), FormIDUtils::MakeFormID(plugin->compileIndex, false, legacyID - 1));
+	// Older builds also skipped the IDs they had assigned earlier in the pass
+	EXPECT_EQ(formIDManager.AssignLegacyFormID(editorID, plugin), FormIDUtils::MakeFormID(plugin->compileIndex, false, legacyID - 2));
+	// and gave up after ten taken IDs instead of searching on
+	EXPECT_EQ(formIDManager.AssignLegacyFormID(crowdedEditorID, plugin), 0u);
+
+	// The stable FormIDs are assigned independently of the replay
+	std::uint32_t conflictFormID = 0;
+	const auto stableID = FormIDUtils::GenerateStableBaseFormID(editorID.str, false);
+	EXPECT_EQ(formIDManager.AssignFormID(editorID, plugin, conflictFormID), FormIDUtils::MakeFormID(plugin->compileIndex, false, stableID));
+
+	FormIDManager stableManager(source, FormIDUtils::HashMode::kStable, false);
+	EXPECT_EQ(stableManager.AssignLegacyFormID(editorID, plugin), 0u);
+}
+
+TEST(FormIDManager, ReplaysTheMisplacedProbeOfOlderBuilds)
+{
+	// Older builds added the plugin's index bits twice when checking a FormID, so Hair.esp's probes landed in Other.esp
+	MemoryHeadPartSource source;
+	source.AddPlugin("Skyrim.esm", false);
+	const auto* plugin = source.AddPlugin("Hair.esp", false);
+	const auto* other = source.AddPlugin("Other.esp", false);
+	const Hash::HashedKey editorID("HairMaleNord01_Unisexy");
+	const auto legacyID = FormIDUtils::GenerateLegacyBaseFormID(editorID.str, false);
+	ASSERT_GE(legacyID, FormIDUtils::FORMID_MIN + 2);
+	source.AddForm(FormIDUtils::MakeFormID(plugin->compileIndex, false, legacyID), "Missed");
+	source.AddForm(FormIDUtils::MakeFormID(other->compileIndex, false, legacyID - 1), "Probed");
+	source.Finalize();
+
+	FormIDManager formIDManager(source, FormIDUtils::HashMode::kMigrate, false);
+	// The form at the hashed FormID went unnoticed
+	EXPECT_EQ(formIDManager.AssignLegacyFormID(editorID, plugin), FormIDUtils::MakeFormID(plugin->compileIndex, false, legacyID));
+	// while the unrelated form the next probe hit moved the FormID after it down
+	EXPECT_EQ(formIDManager.AssignLegacyFormID(editorID, plugin), FormIDUtils::MakeFormID(plugin->compileIndex, false, legacyID - 2));
+}
@@ -0,0 +1,196 @@
+#include "ExtraPartResolver.h"
+#include "MemoryHeadPartSource.h"
+
+#include <gtest/gtest.h>
+
+namespace
+{
+	constexpr std::uint8_t PLAYABLE_MALE = std::to_underlying(HeadPartFlag::kPlayable) | std::to_underlying(HeadPartFlag::kMale);
+	constexpr std::uint8_t MALE = std::to_underlying(HeadPartFlag::kMale);
+	constexpr std::uint8_t GENDERLESS = 0;
+
+	// Resolver over an in-memory source, flipping male parts to female
+	class ExtraPartResolverTest : public testing::Test
+	{
+	protected:
+		void SetUp() override
+		{
+			plugin_ = source_.AddPlugin("Hair.esp", false);
+		}
+
+		FormID AddPart(std::uint32_t a_localID, std::string_view a_editorID, std::uint8_t a_flags)
+		{
+			return source_.AddHeadPart(plugin_, a_localID, a_editorID, HeadPartType::kHair, a_flags);
+		}
+
+		std::vector<FormID> Resolve(FormID a_headPart)
+		{
+			if (!resolver_) {
+				source_.Finalize();
+				editorIDIndex_.Build(source_);
+				resolver_.emplace(formIDManager_, editorIDIndex_, arena_, false, plan_, conflicts_);
+			}
+			std::vector<FormID> extraParts;
+			resolver_->Resolve(source_.FindHeadPart(a_headPart), true, plugin_, extraParts);
+			return extraParts;
+		}
+
+		const PlannedHeadPart* FindPlanned(std::string_view a_editorID) const
+		{
+			const auto it = std::ranges::find(plan_.headParts, a_editorID, &PlannedHeadPart::editorID);
+			return it != plan_.headParts.end() ? &*it : nullptr;
+		}
+
+		MemoryHeadPartSource source_;
+		const PluginInfo* plugin_ = nullptr;
+		StringArena arena_;
+		EditorIDIndex editorIDIndex_;
+		FormIDManager formIDManager_{ source_, FormIDUtils::HashMode::kStable, false };
+		GenerationPlan plan_;
+		std::vector<std::tuple<std::string_view, std::uint32_t, std::uint32_t>> conflicts_;
+		std::optional<ExtraPartResolver> resolver_;
+	};
+}
+
+TEST_F(ExtraPartResolverTest, KeepsPartsThatNeedNoFlip)
+{
+	const auto hair = AddPart(0x800, "Hair", PLAYABLE_MALE);
+	const auto genderless = AddPart(0x801, "Hairline", GENDERLESS);
+	source_.AddExtraPart(hair, genderless);
+
+	EXPECT_EQ(Resolve(hair), std::vector{ genderless });
+	EXPECT_TRUE(plan_.headParts.empty());
+}
+
+TEST_F(ExtraPartResolverTest, PlansNestedPartsBeforeTheirParents)
+{
+	const auto hair = AddPart(0x800, "Hair", PLAYABLE_MALE);
+	const auto outer = AddPart(0x801, "Outer", MALE);
+	const auto inner = AddPart(0x802, "Inner", MALE);
+	source_.AddExtraPart(hair, outer);
+	source_.AddExtraPart(outer, inner);
+
+	const auto extraParts = Resolve(hair);
+	ASSERT_EQ(plan_.headParts.size(), 2u);
+	EXPECT_EQ(plan_.headParts[0].editorID, "Inner_Unisexy");
+	EXPECT_EQ(plan_.headParts[1].editorID, "Outer_Unisexy");
+	EXPECT_EQ(plan_.headParts[1].sourceFormID, outer);
+	EXPECT_EQ(extraParts, std::vector{ plan_.headParts[1].formID });
+
+	const auto outerExtras = plan_.GetExtraParts(plan_.headParts[1]);
+	EXPECT_EQ(std::vector(outerExtras.begin(), outerExtras.end()), std::vector{ plan_.headParts[0].formID });
+	EXPECT_TRUE(plan_.GetExtraParts(plan_.headParts[0]).empty());
+}
+
+TEST_F(ExtraPartResolverTest, SiblingsKeepTheirOwnExtraParts)
+{
+	const auto hair = AddPart(0x800, "Hair", PLAYABLE_MALE);
+	const auto first = AddPart(0x801, "First", MALE);
+	const auto second = AddPart(0x802, "Second", MALE);
+	const auto firstInner = AddPart(0x803, "FirstInner", MALE);
+	const auto kept = AddPart(0x804, "Kept", GENDERLESS);
+	source_.AddExtraPart(hair, first);
+	source_.AddExtraPart(hair, second);
+	source_.AddExtraPart(first, firstInner);
+	source_.AddExtraPart(second, kept);
+
+	EXPECT_EQ(Resolve(hair).size(), 2u);
+
+	const auto* firstPlanned = FindPlanned("First_Unisexy");
+	const auto* secondPlanned = FindPlanned("Second_Unisexy");
+	const auto* innerPlanned = FindPlanned("FirstInner_Unisexy");
+	ASSERT_TRUE(firstPlanned && secondPlanned && innerPlanned);
+	const auto firstExtras = plan_.GetExtraParts(*firstPlanned);
+	const auto secondExtras = plan_.GetExtraParts(*secondPlanned);
+	EXPECT_EQ(std::vector(firstExtras.begin(), firstExtras.end()), std::vector{ innerPlanned->formID });
+	EXPECT_EQ(std::vector(secondExtras.begin(), secondExtras.end()), std::vector{ kept });
+}
+
+TEST_F(ExtraPartResolverTest, CyclesResolveToThePartBeingPlanned)
+{
+	const auto hair = AddPart(0x800, "Hair", PLAYABLE_MALE);
+	const auto a = AddPart(0x801, "A", MALE);
+	const auto b = AddPart(0x802, "B", MALE);
+	source_.AddExtraPart(hair, a);
+	source_.AddExtraPart(a, b);
+	source_.AddExtraPart(b, a);
+
+	const auto extraParts = Resolve(hair);
+	ASSERT_EQ(plan_.headParts.size(), 2u);
+	const auto* aPlanned = FindPlanned("A_Unisexy");
+	const auto* bPlanned = FindPlanned("B_Unisexy");
+	ASSERT_TRUE(aPlanned && bPlanned);
+	EXPECT_EQ(extraParts, std::vector{ aPlanned->formID });
+	EXPECT_EQ(plan_.GetExtraParts(*bPlanned)[0], aPlanned->formID);
+	EXPECT_EQ(plan_.GetExtraParts(*aPlanned)[0], bPlanned->formID);
+}
+
+TEST_F(ExtraPartResolverTest, SharedPartsArePlannedOnce)
+{
+	const auto first = AddPart(0x800, "HairA", PLAYABLE_MALE);
+	const auto second = AddPart(0x801, "HairB", PLAYABLE_MALE);
+	const auto shared = AddPart(0x802, "Shared", MALE);
+	source_.AddExtraPart(first, shared);
+	source_.AddExtraPart(second, shared);
+
+	const auto firstExtras = Resolve(first);
+	const auto secondExtras = Resolve(second);
+	EXPECT_EQ(firstExtras, secondExtras);
+	EXPECT_EQ(plan_.headParts.size(), 1u);
+	EXPECT_EQ(resolver_->GetResolvedCount(), 1u);
+	EXPECT_EQ(resolver_->GetMemoHitCount(), 1u);
+}
+
+TEST_F(ExtraPartResolverTest, DeepChainsStopAtTheDepthLimit)
+{
+	const auto hair = AddPart(0x800, "Hair", PLAYABLE_MALE);
+	auto parent = hair;
+	std::vector<FormID> chain;
+	for (std::uint32_t i = 0; i < 40; ++i) {
+		const auto part = AddPart(0x900 + i, "Chain" + std::to_string(i), MALE);
+		source_.AddExtraPart(parent, part);
+		chain.push_back(part);
+		parent = part;
+	}
+
+	Resolve(hair);
+	EXPECT_EQ(resolver_->GetMaxDepth(), 16u);
+	EXPECT_EQ(plan_.headParts.size(), 16u);
+
+	// The deepest planned part keeps its source's extra part as it is
+	const auto* deepest = FindPlanned("Chain15_Unisexy");
+	ASSERT_TRUE(deepest);
+	EXPECT_EQ(plan_.GetExtraParts(*deepest)[0], chain[16]);
+}
+
+TEST_F(ExtraPartResolverTest, PartsReachedByManyPathsAreResolvedOnce)
+{
+	// Each level links both of its parts to both parts of the next, so the last level is reached by 2^10 paths
+	const auto hair = AddPart(0x800, "Hair", PLAYABLE_MALE);
+	std::vector<FormID> level{ hair };
+	for (std::uint32_t depth = 0; depth < 10; ++depth) {
+		std::vector<FormID> nextLevel;
+		for (std::uint32_t i = 0; i < 2; ++i) {
+			nextLevel.push_back(AddPart(0x900 + depth * 2 + i, "Level" + std::to_string(depth) + "_" + std::to_string(i), MALE));
+		}
+		for (const auto parent : level) {
+			for (const auto child : nextLevel) {
+				source_.AddExtraPart(parent, child);
+			}
+		}
+		level = std::move(nextLevel);
+	}
+
+	EXPECT_EQ(Resolve(hair).size(), 2u);
+	EXPECT_EQ(plan_.headParts.size(), 20u);
+	EXPECT_EQ(resolver_->GetResolvedCount(), 20u);
+	// The 36 links between levels reach 18 parts; every link after the first into a part is answered by the memo
+	EXPECT_EQ(resolver_->GetMemoHitCount(), 18u);
+
+	const auto* planned = FindPlanned("Level4_1_Unisexy");
+	ASSERT_TRUE(planned);
+	const auto extras = plan_.GetExtraParts(*planned);
+	ASSERT_EQ(extras.size(), 2u);
+	EXPECT_EQ(extras[0], FindPlanned("Level5_0_Unisexy")->formID);
+	EXPECT_EQ(extras[1], FindPlanned("Level5_1_Unisexy")->formID);
+}
@@ -0,0 +1,190 @@
+#include "FormIDUtils.h"
+#include "GenerationCacheFormat.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+namespace
+{
+	constexpr std::uint64_t KEY = 0x0123456789ABCDEF;
+
+	// Encodes a small plan against one load order and decodes it against another
+	class GenerationCacheFormatTest : public testing::Test
+	{
+	protected:
+		void SetUp() override
+		{
+			// Corrupted inputs are expected to log errors
+			spdlog::set_level(spdlog::level::off);
+
+			const auto hair = FormIDUtils::MakeFormID(0x01, false, 0x800);
+			const auto extra = FormIDUtils::MakeFormID(0x002, true, 0x801);
+			const auto removed = FormIDUtils::MakeFormID(0x03, false, 0x802);
+			plan_.plugins.push_back({ "Hair.esp", 0x1111 });
+			plan_.plugins.push_back({ "Removed.esp", 0x2222 });
+			plan_.Add(extra, FormIDUtils::MakeFormID(0x002, true, 0x900), "Extra_Unisexy", true, {});
+			const std::array extraParts{ plan_.headParts[0].formID, removed, FormID{ 0x00000123 } };
+			plan_.Add(hair, FormIDUtils::MakeFormID(0x01, false, 0x901), "Hair_Unisexy", false, extraParts).legacyFormID =
+				FormIDUtils::MakeFormID(0x01, false, 0x902);
+			plan_.disabledParts.push_back(hair);
+			data_ = GenerationCacheFormat::Encode(KEY, plan_, GetPluginName);
+		}
+
+		void TearDown() override
+		{
+			spdlog::set_level(spdlog::level::info);
+		}
+
+		// Plugins of the load order the plan was generated in
+		static std::string_view GetPluginName(FormID a_formID)
+		{
+			if (FormIDUtils::IsLightFormID(a_formID)) {
+				return FormIDUtils::GetFileIndex(a_formID) == 0x002 ? "Extra.esl"sv : ""sv;
+			}
+			switch (FormIDUtils::GetFileIndex(a_formID)) {
+			case 0x01:
+				return "Hair.esp";
+			case 0x03:
+				return "Removed.esp";
+			default:
+				return {};
+			}
+		}
+
+		// Later load order: Hair.esp moved, Extra.esl got another light slot and Removed.esp is gone
+		static std::optional<PluginInfo> FindPlugin(std::string_view a_fileName)
+		{
+			if (a_fileName == "Hair.esp") {
+				return PluginInfo{ a_fileName, 0x05, false };
+			}
+			if (a_fileName == "Extra.esl") {
+				return PluginInfo{ a_fileName, 0x010, true };
+			}
+			return std::nullopt;
+		}
+
+		GenerationCacheFormat::DecodeResult Decode(std::span<const std::byte> a_data, GenerationPlan& a_outPlan) const
+		{
+			return GenerationCacheFormat::Decode(a_data, KEY, FindPlugin, a_outPlan);
+		}
+
+		// A decoded plan must be safe to walk whatever the input was
+		static void ExpectConsistent(const GenerationPlan& a_plan)
+		{
+			for (const auto& planned : a_plan.headParts) {
+				EXPECT_LE(std::uint64_t{ planned.extraPartsBegin } + planned.extraPartsCount, a_plan.extraParts.size());
+				EXPECT_EQ(planned.editorID.data()[planned.editorID.size()], '\0');
+			}
+			for (const auto& plugin : a_plan.plugins) {
+				EXPECT_EQ(plugin.fileName.data()[plugin.fileName.size()], '\0');
+			}
+		}
+
+		GenerationPlan plan_;
+		std::vector<std::byte> data_;
+	};
+}
+
+TEST_F(GenerationCacheFormatTest, RoundTripRemapsPlugins)
+{
+	GenerationPlan decoded;
+	ASSERT_EQ(Decode(data_, decoded), GenerationCacheFormat::DecodeResult::kOk);
+
+	ASSERT_EQ(decoded.plugins.size(), 2u);
+	EXPECT_EQ(decoded.plugins[0].fileName, "Hair.esp");
+	EXPECT_EQ(decoded.plugins[0].fingerprint, 0x1111u);
+	EXPECT_EQ(decoded.plugins[1].fileName, "Removed.esp");
+
+	ASSERT_EQ(decoded.headParts.size(), 2u);
+	const auto& extra = decoded.headParts[0];
+	const auto& hair = decoded.headParts[1];
+	EXPECT_EQ(extra.sourceFormID, FormIDUtils::MakeFormID(0x010, true, 0x801));
+	EXPECT_EQ(extra.formID, FormIDUtils::MakeFormID(0x010, true, 0x900));
+	EXPECT_EQ(extra.editorID, "Extra_Unisexy");
+	EXPECT_TRUE(extra.toFemale);
+	EXPECT_EQ(hair.sourceFormID, FormIDUtils::MakeFormID(0x05, false, 0x800));
+	EXPECT_EQ(hair.formID, FormIDUtils::MakeFormID(0x05, false, 0x901));
+	EXPECT_EQ(hair.legacyFormID, FormIDUtils::MakeFormID(0x05, false, 0x902));
+	EXPECT_EQ(extra.legacyFormID, 0u);
+	EXPECT_FALSE(hair.toFemale);
+
+	// Unloaded plugins resolve to 0 and FormIDs outside any plugin are kept as they are
+	const auto extraParts = decoded.GetExtraParts(hair);
+	EXPECT_EQ(std::vector(extraParts.begin(), extraParts.end()), (std::vector<FormID>{ extra.formID, 0, 0x00000123 }));
+	EXPECT_EQ(decoded.disabledParts, std::vector{ hair.sourceFormID });
+}
+
+TEST_F(GenerationCacheFormatTest, RejectsOtherKeysAndVersions)
+{
+	GenerationPlan decoded;
+	EXPECT_EQ(GenerationCacheFormat::Decode(data_, KEY + 1, FindPlugin, decoded), GenerationCacheFormat::DecodeResult::kOutOfDate);
+
+	auto data = data_;
+	data[4] ^= std::byte{ 0x01 };
+	EXPECT_EQ(Decode(data, decoded), GenerationCacheFormat::DecodeResult::kUnsupported);
+	EXPECT_TRUE(decoded.headParts.empty());
+}
+
+TEST_F(GenerationCacheFormatTest, ViewValidatesRecordsAsTheyAreRead)
+{
+	// Point the second head part record's EditorID past the string table
+	const auto pluginCount = std::to_integer<std::uint32_t>(data_[0x10]);
+	const auto recordOffset = GenerationCacheFormat::HEADER_SIZE + pluginCount * 0x10 + 0x28;
+	auto data = data_;
+	data[recordOffset + 0x1B] = std::byte{ 0x7F };
+
+	GenerationCacheFormat::View view;
+	ASSERT_EQ(view.Open(data, KEY, FindPlugin), GenerationCacheFormat::DecodeResult::kOk);
+	EXPECT_EQ(view.GetPlugins().size(), 2u);
+	ASSERT_EQ(view.GetPartCount(), 2u);
+
+	const auto extra = view.GetPart(0);
+	ASSERT_TRUE(extra);
+	EXPECT_EQ(extra->editorID, "Extra_Unisexy");
+	EXPECT_FALSE(view.GetPart(1));
+	EXPECT_FALSE(view.GetPart(2));
+	EXPECT_FALSE(view.GetExtraPart(view.GetExtraCount()));
+
+	GenerationPlan decoded;
+	EXPECT_EQ(Decode(data, decoded), GenerationCacheFormat::DecodeResult::kCorrupted);
+}
+
+TEST_F(GenerationCacheFormatTest, RejectsEveryTruncation)
+{
+	for (std::size_t size = 0; size < data_.size(); ++size) {
+		// Copy into an allocation of the exact size so sanitizers catch reads past the end
+		const std::vector truncated(data_.begin(), data_.begin() + static_cast<std::ptrdiff_t>(size));
+		GenerationPlan decoded;
+		EXPECT_NE(Decode(truncated, decoded), GenerationCacheFormat::DecodeResult::kOk) << "size " << size;
+	}
+}
+
+TEST_F(GenerationCacheFormatTest, SurvivesEveryBitFlip)
+{
+	for (std::size_t bit = 0; bit < data_.size() * 8; ++bit) {
+		auto data = data_;
+		data[bit / 8] ^= static_cast<std::byte>(1 << (bit % 8));
+		GenerationPlan decoded;
+		if (Decode(data, decoded) == GenerationCacheFormat::DecodeResult::kOk) {
+			ExpectConsistent(decoded);
+		}
+	}
+}
+
+TEST_F(GenerationCacheFormatTest, SurvivesRandomCorruption)
+{
+	std::mt19937 random(1);
+	std::uniform_int_distribution<std::size_t> offset(GenerationCacheFormat::HEADER_SIZE, data_.size() - 1);
+	std::uniform_int_distribution<int> value(0, 0xFF);
+	for (int i = 0; i < 5000; ++i) {
+		auto data = data_;
+		for (int j = 0; j < 4; ++j) {
+			data[offset(random)] = static_cast<std::byte>(value(random));
+		}
+		GenerationPlan decoded;
+		if (Decode(data, decoded) == GenerationCacheFormat::DecodeResult::kOk) {
+			ExpectConsistent(decoded);
+		}
+	}
+}
@@ -0,0 +1,253 @@
+#include "GenerationPlanner.h"
+#include "MemoryHeadPartSource.h"
+
+#include <gtest/gtest.h>
+
+namespace
+{
+	constexpr std::uint8_t PLAYABLE = std::to_underlying(HeadPartFlag::kPlayable);
+	constexpr std::uint8_t PLAYABLE_MALE = PLAYABLE | std::to_underlying(HeadPartFlag::kMale);
+	constexpr std::uint8_t PLAYABLE_FEMALE = PLAYABLE | std::to_underlying(HeadPartFlag::kFemale);
+	constexpr std::uint8_t MALE = std::to_underlying(HeadPartFlag::kMale);
+
+	// Planner over an in-memory source with every hair and brow toggle enabled
+	class GenerationPlannerTest : public testing::Test
+	{
+	protected:
+		void SetUp() override
+		{
+			std::array<HeadPartClassifier::TypeToggles, HeadPartClassifier::TYPE_COUNT> toggles{};
+			toggles[std::to_underlying(HeadPartType::kHair)] = { true, true };
+			toggles[std::to_underlying(HeadPartType::kEyebrows)] = { false, true };
+			toggles[std::to_underlying(HeadPartType::kFace)] = { true, true };
+			classifier_.Build(toggles);
+
+			options_.classifier = &classifier_;
+			options_.rules = &rules_;
+			options_.hashMode = FormIDUtils::HashMode::kStable;
+
+			plugin_ = source_.AddPlugin("Hair.esp", false);
+		}
+
+		FormID AddPart(std::uint32_t a_localID, std::string_view a_editorID, HeadPartType a_type, std::uint8_t a_flags, const PluginInfo* a_file = nullptr)
+		{
+			return source_.AddHeadPart(a_file ? a_file : plugin_, a_localID, a_editorID, a_type, a_flags);
+		}
+
+		GenerationPlanner& Plan()
+		{
+			source_.Finalize();
+			planner_.emplace(source_, std::move(options_));
+			planner_->Plan(phaseTimer_);
+			return *planner_;
+		}
+
+		const PlannedHeadPart* FindPlanned(std::string_view a_editorID) const
+		{
+			const auto& headParts = planner_->GetPlan().headParts;
+			const auto it = std::ranges::find(headParts, a_editorID, &PlannedHeadPart::editorID);
+			return it != headParts.end() ? &*it : nullptr;
+		}
+
+		MemoryHeadPartSource source_;
+		const PluginInfo* plugin_ = nullptr;
+		HeadPartClassifier classifier_;
+		HeadPartRules rules_;
+		GenerationPlanner::Options options_;
+		PhaseTimer phaseTimer_;
+		std::optional<GenerationPlanner> planner_;
+	};
+}
+
+TEST_F(GenerationPlannerTest, FlipsEnabledParts)
+{
+	const auto male = AddPart(0x800, "HairMale", HeadPartType::kHair, PLAYABLE_MALE);
+	const auto female = AddPart(0x801, "HairFemale", HeadPartType::kHair, PLAYABLE_FEMALE);
+
+	const auto& planner = Plan();
+	const auto* toFemale = FindPlanned("HairMale_Unisexy");
+	const auto* toMale = FindPlanned("HairFemale_Unisexy");
+	ASSERT_TRUE(toFemale && toMale);
+	EXPECT_EQ(toFemale->sourceFormID, male);
+	EXPECT_TRUE(toFemale->toFemale);
+	EXPECT_EQ(toMale->sourceFormID, female);
+	EXPECT_FALSE(toMale->toFemale);
+	EXPECT_EQ(FormIDUtils::GetFileIndex(toFemale->formID), plugin_->compileIndex);
+	EXPECT_EQ(planner.GetStats().processedCount, 2);
+	EXPECT_TRUE(planner.GetPlan().disabledParts.empty());
+}
+
+TEST_F(GenerationPlannerTest, CountsSkipsAndWarnings)
+{
+	AddPart(0x800, "BrowsFemale", HeadPartType::kEyebrows, PLAYABLE_FEMALE);
+	AddPart(0x801, "", HeadPartType::kHair, PLAYABLE_MALE);
+	AddPart(0x802, "HairNPC", HeadPartType::kHair, MALE);
+	AddPart(0x803, "Scar", HeadPartType::kScar, PLAYABLE_MALE);
+
+	const auto& planner = Plan();
+	EXPECT_TRUE(planner.GetPlan().headParts.empty());
+	EXPECT_EQ(planner.GetStats().processedCount, 4);
+	EXPECT_EQ(planner.GetStats().otherWarningCount, 1);
+
+	const auto& skipped = planner.GetSkippedByType();
+	EXPECT_EQ(skipped.at(HeadPartType::kEyebrows), std::pair(1, 0));
+	EXPECT_EQ(skipped.at(HeadPartType::kScar), std::pair(0, 1));
+}
+
+TEST_F(GenerationPlannerTest, ShowOnlyUnisexyHidesOriginalsAndGenderlessParts)
+{
+	options_.showOnlyUnisexy = true;
+	const auto male = AddPart(0x800, "HairMale", HeadPartType::kHair, PLAYABLE_MALE);
+	const auto genderless = AddPart(0x801, "HairAny", HeadPartType::kHair, PLAYABLE);
+
+	const auto& planner = Plan();
+	EXPECT_EQ(planner.GetPlan().disabledParts, (std::vector{ male, genderless }));
+	EXPECT_EQ(planner.GetStats().disabledOriginalCount, 2);
+}
+
+TEST_F(GenerationPlannerTest, RulesMatchTheDefiningPlugin)
+{
+	const auto* overrides = source_.AddPlugin("Overrides.esp", false);
+	const auto* excluded = source_.AddPlugin("Excluded.esp", false);
+	rules_.Add(HeadPartRules::Kind::kExcludePlugin, "Excluded.esp");
+	rules_.Add(HeadPartRules::Kind::kExcludeEditorID, "*Beard*");
+
+	source_.AddHeadPart(overrides, 0x800, "HairOverridden", HeadPartType::kHair, PLAYABLE_MALE, excluded);
+	AddPart(0x801, "HairBeard", HeadPartType::kHair, PLAYABLE_MALE);
+	AddPart(0x802, "HairKept", HeadPartType::kHair, PLAYABLE_MALE, overrides);
+
+	const auto& planner = Plan();
+	ASSERT_EQ(planner.GetPlan().headParts.size(), 1u);
+	EXPECT_EQ(planner.GetPlan().headParts[0].editorID, "HairKept_Unisexy");
+}
+
+TEST_F(GenerationPlannerTest, SkipsDuplicatesAndEarlierPasses)
+{
+	const auto* cached = source_.AddPlugin("Cached.esp", false);
+	AddPart(0x800, "HairMale", HeadPartType::kHair, PLAYABLE_MALE);
+	AddPart(0x801, "HairMale_Unisexy", HeadPartType::kHair, PLAYABLE_FEMALE);
+	AddPart(0x802, "HairRestored", HeadPartType::kHair, PLAYABLE_MALE, cached);
+	const auto generated = AddPart(0x803, "HairGenerated", HeadPartType::kHair, PLAYABLE_MALE);
+	AddPart(0x804, "FaceFemale", HeadPartType::kFace, PLAYABLE_FEMALE);
+	options_.skippedFiles.insert(cached);
+	options_.skippedSources.insert(generated);
+	options_.skippedToggles.set(GetToggleIndex(HeadPartType::kFace, false));
+
+	// HairMale_Unisexy exists already and is flipped back to HairMale_Unisexy_Unisexy
+	const auto& planner = Plan();
+	ASSERT_EQ(planner.GetPlan().headParts.size(), 1u);
+	EXPECT_EQ(planner.GetPlan().headParts[0].editorID, "HairMale_Unisexy_Unisexy");
+	EXPECT_EQ(planner.GetStats().processedCount, 3);
+}
+
+TEST_F(GenerationPlannerTest, OnlyReportableTypesFlipExtraParts)
+{
+	const auto hair = AddPart(0x800, "HairMale", HeadPartType::kHair, PLAYABLE_MALE);
+	const auto face = AddPart(0x801, "FaceMale", HeadPartType::kFace, PLAYABLE_MALE);
+	const auto extra = AddPart(0x802, "Hairline", HeadPartType::kMisc, MALE);
+	source_.AddExtraPart(hair, extra);
+	source_.AddExtraPart(face, extra);
+
+	const auto& planner = Plan();
+	const auto* flippedExtra = FindPlanned("Hairline_Unisexy");
+	const auto* flippedHair = FindPlanned("HairMale_Unisexy");
+	const auto* flippedFace = FindPlanned("FaceMale_Unisexy");
+	ASSERT_TRUE(flippedExtra && flippedHair && flippedFace);
+	EXPECT_EQ(planner.GetPlan().GetExtraParts(*flippedHair)[0], flippedExtra->formID);
+	EXPECT_EQ(planner.GetPlan().GetExtraParts(*flippedFace)[0], extra);
+}
+
+TEST_F(GenerationPlannerTest, ReportsConflicts)
+{
+	const Hash::HashedKey editorID("HairMale_Unisexy");
+	const auto hashedID = FormIDUtils::GenerateBaseFormID(editorID, false, FormIDUtils::HashMode::kStable);
+	source_.AddForm(FormIDUtils::MakeFormID(plugin_->compileIndex, false, hashedID));
+	AddPart(0x800, "HairMale", HeadPartType::kHair, PLAYABLE_MALE);
+
+	const auto& planner = Plan();
+	ASSERT_EQ(planner.GetConflicts().size(), 1u);
+	const auto& [conflictEditorID, conflictFormID, finalFormID] = planner.GetConflicts()[0];
+	EXPECT_EQ(conflictEditorID, "HairMale_Unisexy");
+	EXPECT_EQ(FormIDUtils::GetLocalID(conflictFormID), hashedID);
+	EXPECT_EQ(finalFormID, planner.GetPlan().headParts[0].formID);
+	EXPECT_EQ(planner.GetStats().formIDConflictCount, 1);
+}
+
+TEST_F(GenerationPlannerTest, MigrateRecordsLegacyFormIDsOfPartsOlderBuildsCreated)
+{
+	options_.hashMode = FormIDUtils::HashMode::kMigrate;
+	const auto hair = AddPart(0x800, "HairMale", HeadPartType::kHair, PLAYABLE_MALE);
+	const auto extra = AddPart(0x801, "Hairline", HeadPartType::kMisc, MALE);
+	const auto nested = AddPart(0x802, "HairlineInner", HeadPartType::kMisc, MALE);
+	source_.AddExtraPart(hair, extra);
+	source_.AddExtraPart(extra, nested);
+
+	Plan();
+	const auto* flippedHair = FindPlanned("HairMale_Unisexy");
+	const auto* flippedExtra = FindPlanned("Hairline_Unisexy");
+	const auto* flippedNested = FindPlanned("HairlineInner_Unisexy");
+	ASSERT_TRUE(flippedHair && flippedExtra && flippedNested);
+
+	// Older builds flipped head parts and their direct extra parts, in that order, and no nested ones
+	const auto legacyFormID = [&](std::string_view a_editorID) {
+		return FormIDUtils::MakeFormID(plugin_->compileIndex, false, FormIDUtils::GenerateLegacyBaseFormID(a_editorID, false));
+	};
+	EXPECT_EQ(flippedHair->legacyFormID, legacyFormID("HairMale_Unisexy"));
+	EXPECT_EQ(flippedExtra->legacyFormID, legacyFormID("Hairline_Unisexy"));
+	EXPECT_EQ(flippedNested->legacyFormID, 0u);
+}
+
+TEST_F(GenerationPlannerTest, NestedExtraPartsCannotShiftTheFormIDsOfDirectOnes)
+{
+	// Older builds flipped a head part and then its direct extra parts, so those must take their FormIDs first
+	options_.hashMode = FormIDUtils::HashMode::kLegacy;
+	const auto* plugin = source_.AddPlugin("Hair.esl", true);
+	const auto hashedID = [](std::string_view a_editorID) {
+		return FormIDUtils::GenerateLegacyBaseFormID(fmt::format("{}_Unisexy", a_editorID), true);
+	};
+
+	// Pick a nested part hashing above the second direct extra part, and occupy everything in between,
+	// so the nested part would take the direct part's FormID if it were assigned first
+	const auto hairID = hashedID("HairMale");
+	const auto firstID = hashedID("Hairline");
+	const auto secondID = hashedID("HairlineBack");
+	std::string nestedEditorID;
+	std::uint32_t nestedID = 0;
+	for (std::uint32_t i = 0; i < 1000; ++i) {
+		auto candidate = fmt::format("HairlineInner{}", i);
+		const auto candidateID = hashedID(candidate);
+		const auto inRange = [&](std::uint32_t a_id) { return a_id + 1 >= secondID && a_id <= candidateID; };
+		if (candidateID > secondID && (!nestedID || candidateID < nestedID) && !inRange(hairID) && !inRange(firstID)) {
+			nestedEditorID = std::move(candidate);
+			nestedID = candidateID;
+		}
+	}
+	ASSERT_NE(nestedID, 0u);
+	ASSERT_NE(hairID, firstID);
+	ASSERT_GT((std::min)({ hairID, firstID, secondID - 1 }), FormIDUtils::FORMID_MIN + 3);  // Clear of the sources
+	for (auto id = secondID + 1; id <= nestedID; ++id) {
+		source_.AddForm(FormIDUtils::MakeFormID(plugin->compileIndex, true, id));
+	}
+
+	const auto hair = AddPart(0x800, "HairMale", HeadPartType::kHair, PLAYABLE_MALE, plugin);
+	const auto first = AddPart(0x801, "Hairline", HeadPartType::kMisc, MALE, plugin);
+	const auto second = AddPart(0x802, "HairlineBack", HeadPartType::kMisc, MALE, plugin);
+	const auto nested = AddPart(0x803, nestedEditorID, HeadPartType::kMisc, MALE, plugin);
+	source_.AddExtraPart(hair, first);
+	source_.AddExtraPart(hair, second);
+	source_.AddExtraPart(first, nested);
+
+	Plan();
+	const auto* flippedHair = FindPlanned("HairMale_Unisexy");
+	const auto* flippedFirst = FindPlanned("Hairline_Unisexy");
+	const auto* flippedSecond = FindPlanned("HairlineBack_Unisexy");
+	const auto* flippedNested = FindPlanned(fmt::format("{}_Unisexy", nestedEditorID));
+	ASSERT_TRUE(flippedHair && flippedFirst && flippedSecond && flippedNested);
+
+	const auto formID = [&](std::uint32_t a_localID) { return FormIDUtils::MakeFormID(plugin->compileIndex, true, a_localID); };
+	EXPECT_EQ(flippedHair->formID, formID(hairID));
+	EXPECT_EQ(flippedFirst->formID, formID(firstID));
+	EXPECT_EQ(flippedSecond->formID, formID(secondID));
+	// The nested part counts down past the occupied FormIDs and the second direct part
+	EXPECT_EQ(flippedNested->formID, formID(secondID - 1));
+}